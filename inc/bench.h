@@ -0,0 +1,9 @@
+#ifndef GUARD_NESINC_BENCH_H_
+#define GUARD_NESINC_BENCH_H_
+
+#include "common.h"
+
+/* Runs the benchmarks (nesinc --bench) and prints how fast each one ran */
+void benchRun(void);
+
+#endif	// GUARD_NESINC_BENCH_H_
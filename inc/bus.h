@@ -3,32 +3,146 @@
 
 #include "common.h"
 #include "joypad.h"
+#include "mapper.h"
 #include "ppu.h"
 #include "rom.h"
+#include "scheduler.h"
 
 #define BUS_CALLBACK_FN void (*callback)(PPU *, Joypad *, Joypad *)
 
-typedef struct _Bus {
+/* PRG ROM ($8000-$FFFF) is tracked in 8KB windows, the smallest bank size
+ * used by mappers
+ */
+#define BUS_PRG_WINDOW_SIZE 0x2000
+#define BUS_PRG_WINDOWS 4
+
+/* CPU cycles an OAM DMA halts the CPU for, before alignment */
+#define BUS_DMA_CYCLES 513
+
+#define BUS_PAGE_SIZE 0x100
+#define BUS_PAGES 256
+
+typedef struct _Bus Bus;
+
+/* Bits of the CPU's pendingEvents word, which the bus sets whenever the CPU
+ * has something to do before its next instruction
+ */
+typedef enum {
+	PENDING_NMI = 1 << 0, /* The PPU raised an NMI */
+	PENDING_IRQ = 1 << 1, /* The IRQ line is asserted and I isn't masking it */
+} PendingEvent;
+
+/* Devices that can pull the CPU's IRQ line low. The line stays asserted for
+ * as long as any of them hold it
+ */
+typedef enum {
+	IRQ_MAPPER = 1 << 0,
+} IRQSource;
+
+typedef uint8_t (*BusReadFn)(Bus *bus, const uint16_t ADDRESS);
+typedef void (*BusWriteFn)(Bus *bus, const uint16_t ADDRESS,
+						   const uint8_t VALUE);
+
+/* One entry per 256 byte page of the CPU address space
+ *
+ * Plain memory (RAM, PRG ROM) is accessed straight through the host pointer
+ * to the start of the page. Pages without one (I/O, writes to ROM) go through
+ * the page's handler instead
+ */
+typedef struct _BusPage {
+	uint8_t *read;
+	uint8_t *write;
+
+	BusReadFn readFn;
+	BusWriteFn writeFn;
+} BusPage;
+
+struct _Bus {
+	BusPage pages[BUS_PAGES];
+
 	uint8_t cpuVRAM[2048];
 	ROM rom;
+	Mapper mapper;
 	PPU ppu;
 
 	size_t cycles;
+	size_t ppuCycles; /* Bus clock the PPU has been caught up to */
+
+	Scheduler sched;
+	size_t scanlineTime; /* PPU cycle of the next MMC3 counter clock */
+
+	uint8_t irqLines;		/* IRQSource bits holding the IRQ line */
+	bool irqMasked;			/* The CPU's I flag, see busMaskIRQ */
+	uint8_t *pendingEvents; /* The CPU's, see PendingEvent */
+
+	/* Bumped whenever a PRG window gets remapped, so anything decoded from
+	 * it knows it's stale
+	 */
+	uint32_t prgStamps[BUS_PRG_WINDOWS];
 
 	Joypad joy1;
 	Joypad joy2;
 
 	BUS_CALLBACK_FN;
-} Bus;
+};
 
-void busInit(Bus *bus, ROM rom, BUS_CALLBACK_FN);
+/* PENDING is the CPU's pendingEvents word */
+void busInit(Bus *bus, const ROM *CART, uint8_t *pending, BUS_CALLBACK_FN);
 
 uint8_t busRead(Bus *bus, const uint16_t ADDRESS);
 uint16_t busRead16(Bus *bus, const uint16_t ADDRESS);
 
+/* Debug reads for tracing and tooling. They return what busRead would, but
+ * leave every register alone. The PPU isn't caught up for them, so its
+ * registers read as of the last time something synced it
+ */
+uint8_t busPeek(const Bus *bus, const uint16_t ADDRESS);
+void busPeekRange(const Bus *bus, const uint16_t START, uint8_t *out,
+				  const size_t COUNT);
+
 void busWrite(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE);
 void busWrite16(Bus *bus, const uint16_t ADDRESS, const uint16_t VALUE);
 
+/* Internal RAM ($0000-$1FFF), for addresses that can't be anything else */
+static inline uint8_t busReadRAM(Bus *bus, const uint16_t ADDRESS) {
+	return bus->cpuVRAM[ADDRESS & 0x07FF];
+}
+
+static inline void busWriteRAM(Bus *bus, const uint16_t ADDRESS,
+							   const uint8_t VALUE) {
+	bus->cpuVRAM[ADDRESS & 0x07FF] = VALUE;
+}
+
+/* PENDING_IRQ is only raised for an IRQ the CPU would actually take, so one
+ * held while I is set doesn't drag every instruction through the slow path
+ */
+static inline void busUpdateIRQ(Bus *bus) {
+	if( bus->irqLines != 0 && !bus->irqMasked ) {
+		*bus->pendingEvents |= PENDING_IRQ;
+	} else {
+		*bus->pendingEvents &= (uint8_t)~PENDING_IRQ;
+	}
+}
+
+static inline void busAssertIRQ(Bus *bus, const IRQSource SOURCE) {
+	bus->irqLines = (uint8_t)(bus->irqLines | SOURCE);
+	busUpdateIRQ(bus);
+}
+
+static inline void busReleaseIRQ(Bus *bus, const IRQSource SOURCE) {
+	bus->irqLines &= (uint8_t)~SOURCE;
+	busUpdateIRQ(bus);
+}
+
+/* The CPU calls this whenever its I flag changes */
+static inline void busMaskIRQ(Bus *bus, const bool MASKED) {
+	bus->irqMasked = MASKED;
+	busUpdateIRQ(bus);
+}
+
 void busTick(Bus *bus, const uint8_t CYCLES);
+void busSyncPPU(Bus *bus);
+
+void busInvalidatePrgWindow(Bus *bus, const uint8_t WINDOW);
 
 #endif	// GUARD_NESINC_BUS_H_
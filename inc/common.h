@@ -7,4 +7,8 @@
 
 #define UNUSED(X) (void)X
 
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#define NOINLINE __attribute__((noinline))
+#define UNLIKELY(X) __builtin_expect(!!(X), 0)
+
 #endif	// GUARD_NESINC_COMMON_H_
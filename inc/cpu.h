@@ -1,6 +1,8 @@
 #ifndef GUARD_NESINC_CPU_H_
 #define GUARD_NESINC_CPU_H_
 
+#include <stdio.h>
+
 #include "bus.h"
 #include "common.h"
 
@@ -19,6 +21,8 @@
  * └───────── Negative
  */
 
+#define CARRY_BIT (uint8_t)(1 << 0)
+#define ZERO_BIT (uint8_t)(1 << 1)
 #define BFLAG1_BIT (uint8_t)(1 << 4)
 #define BFLAG2_BIT (uint8_t)(1 << 5)
 #define OVERFLOW_BIT (uint8_t)(1 << 6)
@@ -39,7 +43,18 @@ typedef union _CPUStatus {
 	uint8_t bits;
 } CPUStatus;
 
+typedef struct _DecodedOp DecodedOp;
+typedef struct _Jit Jit;
+typedef struct _WatchList WatchList;
+typedef struct _Trace Trace;
+typedef struct _TraceRecord TraceRecord;
+
 typedef struct _CPU {
+	/* PendingEvent bits. The run loop tests this once per instruction and
+	 * only looks any further when something is set
+	 */
+	uint8_t pendingEvents;
+
 	uint8_t regA; /* Register A */
 	uint8_t regX; /* Register X */
 	uint8_t regY; /* Register Y */
@@ -48,15 +63,31 @@ typedef struct _CPU {
 
 	CPUStatus status;
 
+	/* Zero and negative are evaluated lazily: Z is set if zeroResult is 0,
+	 * and N is bit 7 of negResult. While running, go through cpuGetStatus and
+	 * cpuSetStatus instead of status.bits
+	 */
+	uint8_t zeroResult;
+	uint8_t negResult;
+
 	uint8_t stack; /* Stack "pointer" ($1000-$10FF) */
 
+	DecodedOp *decoded; /* Decode cache for $8000-$FFFF, only while running */
+	Jit *jit;			/* Block recompiler (JIT=1), only while running */
+	WatchList *watches; /* Memory access callbacks, NULL if there are none */
+	Trace *trace;		/* Execution trace, NULL unless enabled */
+
+	size_t idleCycles; /* Cycles fast-forwarded through idle loops */
+
 	Bus bus;
 } CPU;
 
 void cpuReset(CPU *cpu);
 
-void cpuInit(CPU *cpu, Bus bus);
-void cpuInitFromROM(CPU *cpu, ROM rom);
+void cpuInitFromROM(CPU *cpu, const ROM *CART);
+
+uint8_t cpuGetStatus(CPU *cpu);
+void cpuSetStatus(CPU *cpu, const uint8_t BITS);
 
 uint8_t cpuRead(CPU *cpu, const uint16_t ADDRESS);
 uint16_t cpuRead16(CPU *cpu, const uint16_t ADDRESS);
@@ -67,6 +98,30 @@ void cpuWrite16(CPU *cpu, const uint16_t ADDRESS, const uint16_t VALUE);
 void cpuLoad(CPU *cpu, const uint8_t *CODE, const uint16_t SIZE);
 void cpuLoadAndRun(CPU *cpu, const uint8_t *CODE, const uint16_t SIZE);
 
+/* Idle loops are a single load from RAM or PPUSTATUS and a branch back to it,
+ * which can't see anything change until the next scheduled event
+ */
+bool cpuIsIdleLoop(CPU *cpu, const uint16_t HEAD);
+
+/* Fast-forwards the clock through whole iterations of the idle loop at the PC,
+ * stopping short of the next event. PENDING is how many cycles of the branch
+ * that closed the loop haven't been ticked yet
+ */
+void cpuSkipIdleLoop(CPU *cpu, const uint8_t PENDING);
+
+/* Recording into the trace happens before each interpreted instruction. With
+ * JIT=1, compiled blocks only get a record for their first instruction
+ */
+void cpuTraceEnable(CPU *cpu);
+void cpuTraceDisable(CPU *cpu);
+void cpuTraceRecord(CPU *cpu);
+
+/* Renders a record as a nestest-style log line */
+void cpuTraceFormat(const TraceRecord *RECORD, char *out, const size_t SIZE);
+
+/* Prints the last LAST records, oldest first */
+void cpuTraceDump(CPU *cpu, FILE *out, const size_t LAST);
+
 void cpuRun(CPU *cpu);
 
 #endif	// GUARD_NESINC_CPU_H_
@@ -0,0 +1,58 @@
+#ifndef GUARD_NESINC_CPU_ALU_H_
+#define GUARD_NESINC_CPU_ALU_H_
+
+#include "common.h"
+
+/* ALU kernels shared by the interpreter and the JIT
+ *
+ * Results come back widened to 16 bits, with the carry out in bit 8, so the
+ * flags fall out of the arithmetic instead of a chain of comparisons. None of
+ * these branch on their operands
+ */
+
+#define ALU_CARRY_BIT 8
+
+/* P bits for zero and negative, for every byte */
+extern const uint8_t ALU_ZN[256];
+
+static inline bool aluCarry(const uint16_t RESULT) {
+	return (RESULT >> ALU_CARRY_BIT) & 1;
+}
+
+/* A + VALUE + CARRY */
+static inline uint16_t aluAdd(const uint8_t A, const uint8_t VALUE,
+							  const uint8_t CARRY) {
+	return (uint16_t)(A + VALUE + CARRY);
+}
+
+/* A - VALUE - !CARRY. The carry out is set when nothing was borrowed */
+static inline uint16_t aluSub(const uint8_t A, const uint8_t VALUE,
+							  const uint8_t CARRY) {
+	return aluAdd(A, (uint8_t)~VALUE, CARRY);
+}
+
+/* Set when both operands have the same sign and the result doesn't */
+static inline bool aluOverflow(const uint8_t A, const uint8_t VALUE,
+							   const uint8_t RESULT) {
+	return ((A ^ RESULT) & (VALUE ^ RESULT)) >> 7;
+}
+
+/* Shifts and rotates. Bit 8 is the bit that was shifted out */
+
+static inline uint16_t aluAsl(const uint8_t VALUE) {
+	return (uint16_t)(VALUE << 1);
+}
+
+static inline uint16_t aluLsr(const uint8_t VALUE) {
+	return (uint16_t)((VALUE >> 1) | (VALUE & 1) << ALU_CARRY_BIT);
+}
+
+static inline uint16_t aluRol(const uint8_t VALUE, const uint8_t CARRY) {
+	return (uint16_t)(VALUE << 1 | CARRY);
+}
+
+static inline uint16_t aluRor(const uint8_t VALUE, const uint8_t CARRY) {
+	return (uint16_t)(aluLsr(VALUE) | CARRY << 7);
+}
+
+#endif	// GUARD_NESINC_CPU_ALU_H_
@@ -0,0 +1,23 @@
+#ifndef GUARD_NESINC_CPU_JIT_H_
+#define GUARD_NESINC_CPU_JIT_H_
+
+#include "common.h"
+#include "cpu.h"
+
+/* x86-64 basic-block recompiler (built with JIT=1)
+ *
+ * Straight-line runs of PRG ROM code are translated to native code, with
+ * A, X, Y and P kept in host registers for the whole block. Anything it
+ * can't translate (RAM code, unsupported opcodes, interrupts) is left to the
+ * interpreter
+ */
+
+Jit *jitCreate(void);
+void jitDestroy(Jit *jit);
+
+/* Runs the compiled block at the PC, compiling it first if needed. Returns
+ * false if the interpreter should run the next instruction instead
+ */
+bool jitRun(CPU *cpu);
+
+#endif	// GUARD_NESINC_CPU_JIT_H_
@@ -0,0 +1,326 @@
+#ifndef GUARD_NESINC_CPU_OPS_H_
+#define GUARD_NESINC_CPU_OPS_H_
+
+typedef enum {
+	M_IMMEDIATE,
+	M_ZEROPAGE,
+	M_ZEROPAGE_X,
+	M_ZEROPAGE_Y,
+	M_RELATIVE,
+	M_ABSOLUTE,
+	M_ABSOLUTE_X,
+	M_ABSOLUTE_Y,
+	M_INDIRECT,
+	M_INDIRECT_X,
+	M_INDIRECT_Y,
+	M_IMPLIED,
+} AddressingMode;
+
+/* The 6502 opcode table, as an X-macro
+ *
+ * Each entry is X(CODE, FN, MODE, CYCLES, BYTES, NAME), where FN is the handler
+ * (see OP_FN in cpu.c) and MODE is its addressing mode
+ *
+ * BRK and the KIL opcodes aren't listed here, since they halt the CPU instead
+ * of being dispatched to a handler
+ */
+#define CPU_OPS(X)                                                 \
+	X(0x69, _adc, M_IMMEDIATE, 2, 2, "ADC")                        \
+	X(0x65, _adc, M_ZEROPAGE, 3, 2, "ADC")                         \
+	X(0x75, _adc, M_ZEROPAGE_X, 4, 2, "ADC")                       \
+	X(0x6D, _adc, M_ABSOLUTE, 4, 3, "ADC")                         \
+	X(0x7D, _adc, M_ABSOLUTE_X, 4, 3, "ADC")                       \
+	X(0x79, _adc, M_ABSOLUTE_Y, 4, 3, "ADC")                       \
+	X(0x61, _adc, M_INDIRECT_X, 6, 2, "ADC")                       \
+	X(0x71, _adc, M_INDIRECT_Y, 5, 2, "ADC")                       \
+                                                                   \
+	X(0x9F, _ahx, M_ABSOLUTE_Y, 5, 3, "*AHX")                      \
+	X(0x93, _ahx, M_INDIRECT_Y, 6, 2, "*AHX")                      \
+                                                                   \
+	X(0x4B, _alr, M_IMMEDIATE, 2, 2, "*ALR")                       \
+                                                                   \
+	X(0x0B, _anc, M_IMMEDIATE, 2, 2, "*ANC")                       \
+	X(0x2B, _anc, M_IMMEDIATE, 2, 2, "*ANC")                       \
+                                                                   \
+	X(0x29, _and, M_IMMEDIATE, 2, 2, "AND")                        \
+	X(0x25, _and, M_ZEROPAGE, 3, 2, "AND")                         \
+	X(0x35, _and, M_ZEROPAGE_X, 4, 2, "AND")                       \
+	X(0x2D, _and, M_ABSOLUTE, 4, 3, "AND")                         \
+	X(0x3D, _and, M_ABSOLUTE_X, 4, 3, "AND")                       \
+	X(0x39, _and, M_ABSOLUTE_Y, 4, 3, "AND")                       \
+	X(0x21, _and, M_INDIRECT_X, 6, 2, "AND")                       \
+	X(0x31, _and, M_INDIRECT_Y, 5, 2, "AND")                       \
+                                                                   \
+	X(0x6B, _arr, M_IMMEDIATE, 2, 2, "*ARR")                       \
+                                                                   \
+	X(0x0A, _asl, M_IMPLIED, 2, 1, "ASL")                          \
+	X(0x06, _asl, M_ZEROPAGE, 5, 2, "ASL")                         \
+	X(0x16, _asl, M_ZEROPAGE_X, 6, 2, "ASL")                       \
+	X(0x0E, _asl, M_ABSOLUTE, 6, 3, "ASL")                         \
+	X(0x1E, _asl, M_ABSOLUTE_X, 7, 3, "ASL")                       \
+                                                                   \
+	X(0xAB, _atx, M_IMMEDIATE, 2, 2, "*ATX")                       \
+                                                                   \
+	X(0xCB, _axs, M_IMMEDIATE, 2, 2, "*AXS")                       \
+                                                                   \
+	X(0x90, _bcc, M_RELATIVE, 2, 2, "BCC")                         \
+	X(0xB0, _bcs, M_RELATIVE, 2, 2, "BCS")                         \
+	X(0xF0, _beq, M_RELATIVE, 2, 2, "BEQ")                         \
+	X(0xD0, _bne, M_RELATIVE, 2, 2, "BNE")                         \
+                                                                   \
+	X(0x24, _bit, M_ZEROPAGE, 3, 2, "BIT")                         \
+	X(0x2C, _bit, M_ABSOLUTE, 4, 3, "BIT")                         \
+                                                                   \
+	X(0x30, _bmi, M_RELATIVE, 2, 2, "BMI")                         \
+	X(0x10, _bpl, M_RELATIVE, 2, 2, "BPL")                         \
+	X(0x50, _bvc, M_RELATIVE, 2, 2, "BVC")                         \
+	X(0x70, _bvs, M_RELATIVE, 2, 2, "BVS")                         \
+                                                                   \
+	X(0x18, _clc, M_IMPLIED, 2, 1, "CLC")                          \
+	X(0xD8, _cld, M_IMPLIED, 2, 1, "CLD")                          \
+	X(0x58, _cli, M_IMPLIED, 2, 1, "CLI")                          \
+	X(0xB8, _clv, M_IMPLIED, 2, 1, "CLV")                          \
+                                                                   \
+	X(0xC9, _cmp, M_IMMEDIATE, 2, 2, "CMP")                        \
+	X(0xC5, _cmp, M_ZEROPAGE, 3, 2, "CMP")                         \
+	X(0xD5, _cmp, M_ZEROPAGE_X, 4, 2, "CMP")                       \
+	X(0xCD, _cmp, M_ABSOLUTE, 4, 3, "CMP")                         \
+	X(0xDD, _cmp, M_ABSOLUTE_X, 4, 3, "CMP")                       \
+	X(0xD9, _cmp, M_ABSOLUTE_Y, 4, 3, "CMP")                       \
+	X(0xC1, _cmp, M_INDIRECT_X, 6, 2, "CMP")                       \
+	X(0xD1, _cmp, M_INDIRECT_Y, 5, 2, "CMP")                       \
+                                                                   \
+	X(0xE0, _cpx, M_IMMEDIATE, 2, 2, "CPX")                        \
+	X(0xE4, _cpx, M_ZEROPAGE, 3, 2, "CPX")                         \
+	X(0xEC, _cpx, M_ABSOLUTE, 4, 3, "CPX")                         \
+                                                                   \
+	X(0xC0, _cpy, M_IMMEDIATE, 2, 2, "CPY")                        \
+	X(0xC4, _cpy, M_ZEROPAGE, 3, 2, "CPY")                         \
+	X(0xCC, _cpy, M_ABSOLUTE, 4, 3, "CPY")                         \
+                                                                   \
+	X(0xC7, _dcp, M_ZEROPAGE, 5, 2, "*DCP")                        \
+	X(0xD7, _dcp, M_ZEROPAGE_X, 6, 2, "*DCP")                      \
+	X(0xCF, _dcp, M_ABSOLUTE, 6, 3, "*DCP")                        \
+	X(0xDF, _dcp, M_ABSOLUTE_X, 7, 3, "*DCP")                      \
+	X(0xDB, _dcp, M_ABSOLUTE_Y, 7, 3, "*DCP")                      \
+	X(0xC3, _dcp, M_INDIRECT_X, 8, 2, "*DCP")                      \
+	X(0xD3, _dcp, M_INDIRECT_Y, 8, 2, "*DCP")                      \
+                                                                   \
+	X(0xC6, _dec, M_ZEROPAGE, 5, 2, "DEC")                         \
+	X(0xD6, _dec, M_ZEROPAGE_X, 6, 2, "DEC")                       \
+	X(0xCE, _dec, M_ABSOLUTE, 6, 3, "DEC")                         \
+	X(0xDE, _dec, M_ABSOLUTE_X, 7, 3, "DEC")                       \
+                                                                   \
+	X(0xCA, _dex, M_IMPLIED, 2, 1, "DEX")                          \
+	X(0x88, _dey, M_IMPLIED, 2, 1, "DEY")                          \
+                                                                   \
+	X(0x49, _eor, M_IMMEDIATE, 2, 2, "EOR")                        \
+	X(0x45, _eor, M_ZEROPAGE, 3, 2, "EOR")                         \
+	X(0x55, _eor, M_ZEROPAGE_X, 4, 2, "EOR")                       \
+	X(0x4D, _eor, M_ABSOLUTE, 4, 3, "EOR")                         \
+	X(0x5D, _eor, M_ABSOLUTE_X, 4, 3, "EOR")                       \
+	X(0x59, _eor, M_ABSOLUTE_Y, 4, 3, "EOR")                       \
+	X(0x41, _eor, M_INDIRECT_X, 6, 2, "EOR")                       \
+	X(0x51, _eor, M_INDIRECT_Y, 5, 2, "EOR")                       \
+                                                                   \
+	X(0xE6, _inc, M_ZEROPAGE, 5, 2, "INC")                         \
+	X(0xF6, _inc, M_ZEROPAGE_X, 6, 2, "INC")                       \
+	X(0xEE, _inc, M_ABSOLUTE, 6, 3, "INC")                         \
+	X(0xFE, _inc, M_ABSOLUTE_X, 7, 3, "INC")                       \
+                                                                   \
+	X(0xE8, _inx, M_IMPLIED, 2, 1, "INX")                          \
+	X(0xC8, _iny, M_IMPLIED, 2, 1, "INY")                          \
+                                                                   \
+	X(0xE7, _isb, M_ZEROPAGE, 5, 2, "*ISB")                        \
+	X(0xF7, _isb, M_ZEROPAGE_X, 6, 2, "*ISB")                      \
+	X(0xEF, _isb, M_ABSOLUTE, 6, 3, "*ISB")                        \
+	X(0xFF, _isb, M_ABSOLUTE_X, 7, 3, "*ISB")                      \
+	X(0xFB, _isb, M_ABSOLUTE_Y, 7, 3, "*ISB")                      \
+	X(0xE3, _isb, M_INDIRECT_X, 8, 2, "*ISB")                      \
+	X(0xF3, _isb, M_INDIRECT_Y, 8, 2, "*ISB")                      \
+                                                                   \
+	X(0x4C, _jmp, M_ABSOLUTE, 3, 3, "JMP")                         \
+	X(0x6C, _jmp, M_INDIRECT, 5, 3, "JMP")                         \
+                                                                   \
+	X(0x20, _jsr, M_ABSOLUTE, 6, 3, "JSR")                         \
+                                                                   \
+	X(0xBB, _las, M_ABSOLUTE_Y, 4, 3, "*LAS")                      \
+                                                                   \
+	X(0xA7, _lax, M_ZEROPAGE, 3, 2, "*LAX")                        \
+	X(0xB7, _lax, M_ZEROPAGE_Y, 4, 2, "*LAX")                      \
+	X(0xAF, _lax, M_ABSOLUTE, 4, 3, "*LAX")                        \
+	X(0xBF, _lax, M_ABSOLUTE_Y, 4, 3, "*LAX")                      \
+	X(0xA3, _lax, M_INDIRECT_X, 6, 2, "*LAX")                      \
+	X(0xB3, _lax, M_INDIRECT_Y, 5, 2, "*LAX")                      \
+                                                                   \
+	X(0xA9, _lda, M_IMMEDIATE, 2, 2, "LDA")                        \
+	X(0xA5, _lda, M_ZEROPAGE, 3, 2, "LDA")                         \
+	X(0xB5, _lda, M_ZEROPAGE_X, 4, 2, "LDA")                       \
+	X(0xAD, _lda, M_ABSOLUTE, 4, 3, "LDA")                         \
+	X(0xBD, _lda, M_ABSOLUTE_X, 4, 3, "LDA")                       \
+	X(0xB9, _lda, M_ABSOLUTE_Y, 4, 3, "LDA")                       \
+	X(0xA1, _lda, M_INDIRECT_X, 6, 2, "LDA")                       \
+	X(0xB1, _lda, M_INDIRECT_Y, 5, 2, "LDA")                       \
+                                                                   \
+	X(0xA2, _ldx, M_IMMEDIATE, 2, 2, "LDX")                        \
+	X(0xA6, _ldx, M_ZEROPAGE, 3, 2, "LDX")                         \
+	X(0xB6, _ldx, M_ZEROPAGE_Y, 4, 2, "LDX")                       \
+	X(0xAE, _ldx, M_ABSOLUTE, 4, 3, "LDX")                         \
+	X(0xBE, _ldx, M_ABSOLUTE_Y, 4, 3, "LDX")                       \
+                                                                   \
+	X(0xA0, _ldy, M_IMMEDIATE, 2, 2, "LDY")                        \
+	X(0xA4, _ldy, M_ZEROPAGE, 3, 2, "LDY")                         \
+	X(0xB4, _ldy, M_ZEROPAGE_X, 4, 2, "LDY")                       \
+	X(0xAC, _ldy, M_ABSOLUTE, 4, 3, "LDY")                         \
+	X(0xBC, _ldy, M_ABSOLUTE_X, 4, 3, "LDY")                       \
+                                                                   \
+	X(0x4A, _lsr, M_IMPLIED, 2, 1, "LSR")                          \
+	X(0x46, _lsr, M_ZEROPAGE, 5, 2, "LSR")                         \
+	X(0x56, _lsr, M_ZEROPAGE_X, 6, 2, "LSR")                       \
+	X(0x4E, _lsr, M_ABSOLUTE, 6, 3, "LSR")                         \
+	X(0x5E, _lsr, M_ABSOLUTE_X, 7, 3, "LSR")                       \
+                                                                   \
+	X(0xEA, _nop, M_IMPLIED, 2, 1, "NOP")                          \
+                                                                   \
+	X(0x1A, _nop, M_IMPLIED, 2, 1, "*NOP") /* Unofficial NOPs */   \
+	X(0x3A, _nop, M_IMPLIED, 2, 1, "*NOP")                         \
+	X(0x5A, _nop, M_IMPLIED, 2, 1, "*NOP")                         \
+	X(0x7A, _nop, M_IMPLIED, 2, 1, "*NOP")                         \
+	X(0xDA, _nop, M_IMPLIED, 2, 1, "*NOP")                         \
+	X(0xFA, _nop, M_IMPLIED, 2, 1, "*NOP")                         \
+                                                                   \
+	X(0x04, _nop, M_ZEROPAGE, 3, 2, "*NOP") /* DOP (double NOP) */ \
+	X(0x14, _nop, M_ZEROPAGE_X, 4, 2, "*NOP")                      \
+	X(0x34, _nop, M_ZEROPAGE_X, 4, 2, "*NOP")                      \
+	X(0x44, _nop, M_ZEROPAGE, 3, 2, "*NOP")                        \
+	X(0x54, _nop, M_ZEROPAGE_X, 4, 2, "*NOP")                      \
+	X(0x64, _nop, M_ZEROPAGE, 3, 2, "*NOP")                        \
+	X(0x74, _nop, M_ZEROPAGE_X, 4, 2, "*NOP")                      \
+	X(0x80, _nop, M_IMMEDIATE, 2, 2, "*NOP")                       \
+	X(0x82, _nop, M_IMMEDIATE, 2, 2, "*NOP")                       \
+	X(0x89, _nop, M_IMMEDIATE, 2, 2, "*NOP")                       \
+	X(0xC2, _nop, M_IMMEDIATE, 2, 2, "*NOP")                       \
+	X(0xD4, _nop, M_ZEROPAGE_X, 4, 2, "*NOP")                      \
+	X(0xE2, _nop, M_IMMEDIATE, 2, 2, "*NOP")                       \
+	X(0xF4, _nop, M_ZEROPAGE_X, 4, 2, "*NOP")                      \
+                                                                   \
+	X(0x0C, _nop, M_ABSOLUTE, 4, 3, "*NOP") /* TOP (triple NOP) */ \
+	X(0x1C, _nop, M_ABSOLUTE_X, 4, 3, "*NOP")                      \
+	X(0x3C, _nop, M_ABSOLUTE_X, 4, 3, "*NOP")                      \
+	X(0x5C, _nop, M_ABSOLUTE_X, 4, 3, "*NOP")                      \
+	X(0x7C, _nop, M_ABSOLUTE_X, 4, 3, "*NOP")                      \
+	X(0xDC, _nop, M_ABSOLUTE_X, 4, 3, "*NOP")                      \
+	X(0xFC, _nop, M_ABSOLUTE_X, 4, 3, "*NOP")                      \
+                                                                   \
+	X(0x09, _ora, M_IMMEDIATE, 2, 2, "ORA")                        \
+	X(0x05, _ora, M_ZEROPAGE, 3, 2, "ORA")                         \
+	X(0x15, _ora, M_ZEROPAGE_X, 4, 2, "ORA")                       \
+	X(0x0D, _ora, M_ABSOLUTE, 4, 3, "ORA")                         \
+	X(0x1D, _ora, M_ABSOLUTE_X, 4, 3, "ORA")                       \
+	X(0x19, _ora, M_ABSOLUTE_Y, 4, 3, "ORA")                       \
+	X(0x01, _ora, M_INDIRECT_X, 6, 2, "ORA")                       \
+	X(0x11, _ora, M_INDIRECT_Y, 5, 2, "ORA")                       \
+                                                                   \
+	X(0x48, _pha, M_IMPLIED, 3, 1, "PHA")                          \
+	X(0x08, _php, M_IMPLIED, 3, 1, "PHP")                          \
+	X(0x68, _pla, M_IMPLIED, 4, 1, "PLA")                          \
+	X(0x28, _plp, M_IMPLIED, 4, 1, "PLP")                          \
+                                                                   \
+	X(0x27, _rla, M_ZEROPAGE, 5, 2, "*RLA")                        \
+	X(0x37, _rla, M_ZEROPAGE_X, 6, 2, "*RLA")                      \
+	X(0x2F, _rla, M_ABSOLUTE, 6, 3, "*RLA")                        \
+	X(0x3F, _rla, M_ABSOLUTE_X, 7, 3, "*RLA")                      \
+	X(0x3B, _rla, M_ABSOLUTE_Y, 7, 3, "*RLA")                      \
+	X(0x23, _rla, M_INDIRECT_X, 8, 2, "*RLA")                      \
+	X(0x33, _rla, M_INDIRECT_Y, 8, 2, "*RLA")                      \
+                                                                   \
+	X(0x67, _rra, M_ZEROPAGE, 5, 2, "*RRA")                        \
+	X(0x77, _rra, M_ZEROPAGE_X, 6, 2, "*RRA")                      \
+	X(0x6F, _rra, M_ABSOLUTE, 6, 3, "*RRA")                        \
+	X(0x7F, _rra, M_ABSOLUTE_X, 7, 3, "*RRA")                      \
+	X(0x7B, _rra, M_ABSOLUTE_Y, 7, 3, "*RRA")                      \
+	X(0x63, _rra, M_INDIRECT_X, 8, 2, "*RRA")                      \
+	X(0x73, _rra, M_INDIRECT_Y, 8, 2, "*RRA")                      \
+                                                                   \
+	X(0x2A, _rol, M_IMPLIED, 2, 1, "ROL")                          \
+	X(0x26, _rol, M_ZEROPAGE, 5, 2, "ROL")                         \
+	X(0x36, _rol, M_ZEROPAGE_X, 6, 2, "ROL")                       \
+	X(0x2E, _rol, M_ABSOLUTE, 6, 3, "ROL")                         \
+	X(0x3E, _rol, M_ABSOLUTE_X, 7, 3, "ROL")                       \
+                                                                   \
+	X(0x6A, _ror, M_IMPLIED, 2, 1, "ROR")                          \
+	X(0x66, _ror, M_ZEROPAGE, 5, 2, "ROR")                         \
+	X(0x76, _ror, M_ZEROPAGE_X, 6, 2, "ROR")                       \
+	X(0x6E, _ror, M_ABSOLUTE, 6, 3, "ROR")                         \
+	X(0x7E, _ror, M_ABSOLUTE_X, 7, 3, "ROR")                       \
+                                                                   \
+	X(0x40, _rti, M_IMPLIED, 6, 1, "RTI")                          \
+	X(0x60, _rts, M_IMPLIED, 6, 1, "RTS")                          \
+                                                                   \
+	X(0x87, _sax, M_ZEROPAGE, 3, 2, "*SAX")                        \
+	X(0x97, _sax, M_ZEROPAGE_Y, 4, 2, "*SAX")                      \
+	X(0x83, _sax, M_INDIRECT_X, 6, 2, "*SAX")                      \
+	X(0x8F, _sax, M_ABSOLUTE, 4, 3, "*SAX")                        \
+                                                                   \
+	X(0xE9, _sbc, M_IMMEDIATE, 2, 2, "SBC")                        \
+	X(0xEB, _sbc, M_IMMEDIATE, 2, 2, "*SBC")                       \
+                                                                   \
+	X(0xE5, _sbc, M_ZEROPAGE, 3, 2, "SBC")                         \
+	X(0xF5, _sbc, M_ZEROPAGE_X, 4, 2, "SBC")                       \
+	X(0xED, _sbc, M_ABSOLUTE, 4, 3, "SBC")                         \
+	X(0xFD, _sbc, M_ABSOLUTE_X, 4, 3, "SBC")                       \
+	X(0xF9, _sbc, M_ABSOLUTE_Y, 4, 3, "SBC")                       \
+	X(0xE1, _sbc, M_INDIRECT_X, 6, 2, "SBC")                       \
+	X(0xF1, _sbc, M_INDIRECT_Y, 5, 2, "SBC")                       \
+                                                                   \
+	X(0x38, _sec, M_IMPLIED, 2, 1, "SEC")                          \
+	X(0xF8, _sed, M_IMPLIED, 2, 1, "SED")                          \
+	X(0x78, _sei, M_IMPLIED, 2, 1, "SEI")                          \
+                                                                   \
+	X(0x9E, _shx, M_ABSOLUTE_Y, 3, 3, "*SHX")                      \
+	X(0x9C, _shy, M_ABSOLUTE_X, 5, 3, "*SHY")                      \
+                                                                   \
+	X(0x07, _slo, M_ZEROPAGE, 5, 2, "*SLO")                        \
+	X(0x17, _slo, M_ZEROPAGE_X, 6, 2, "*SLO")                      \
+	X(0x0F, _slo, M_ABSOLUTE, 6, 3, "*SLO")                        \
+	X(0x1F, _slo, M_ABSOLUTE_X, 7, 3, "*SLO")                      \
+	X(0x1B, _slo, M_ABSOLUTE_Y, 7, 3, "*SLO")                      \
+	X(0x03, _slo, M_INDIRECT_X, 8, 2, "*SLO")                      \
+	X(0x13, _slo, M_INDIRECT_Y, 8, 2, "*SLO")                      \
+                                                                   \
+	X(0x47, _sre, M_ZEROPAGE, 5, 2, "*SLO")                        \
+	X(0x57, _sre, M_ZEROPAGE_X, 6, 2, "*SLO")                      \
+	X(0x4F, _sre, M_ABSOLUTE, 6, 3, "*SLO")                        \
+	X(0x5F, _sre, M_ABSOLUTE_X, 7, 3, "*SLO")                      \
+	X(0x5B, _sre, M_ABSOLUTE_Y, 7, 3, "*SLO")                      \
+	X(0x43, _sre, M_INDIRECT_X, 8, 2, "*SLO")                      \
+	X(0x53, _sre, M_INDIRECT_Y, 8, 2, "*SLO")                      \
+                                                                   \
+	X(0x85, _sta, M_ZEROPAGE, 3, 2, "STA")                         \
+	X(0x95, _sta, M_ZEROPAGE_X, 4, 2, "STA")                       \
+	X(0x8D, _sta, M_ABSOLUTE, 4, 3, "STA")                         \
+	X(0x9D, _sta, M_ABSOLUTE_X, 5, 3, "STA")                       \
+	X(0x99, _sta, M_ABSOLUTE_Y, 5, 3, "STA")                       \
+	X(0x81, _sta, M_INDIRECT_X, 6, 2, "STA")                       \
+	X(0x91, _sta, M_INDIRECT_Y, 6, 2, "STA")                       \
+                                                                   \
+	X(0x86, _stx, M_ZEROPAGE, 3, 2, "STX")                         \
+	X(0x96, _stx, M_ZEROPAGE_Y, 4, 2, "STX")                       \
+	X(0x8E, _stx, M_ABSOLUTE, 4, 3, "STX")                         \
+                                                                   \
+	X(0x84, _sty, M_ZEROPAGE, 3, 2, "STY")                         \
+	X(0x94, _sty, M_ZEROPAGE_X, 4, 2, "STY")                       \
+	X(0x8C, _sty, M_ABSOLUTE, 4, 3, "STY")                         \
+                                                                   \
+	X(0x9B, _tas, M_ABSOLUTE_Y, 5, 3, "*TAS")                      \
+                                                                   \
+	X(0xAA, _tax, M_IMPLIED, 2, 1, "TAX")                          \
+	X(0xA8, _tay, M_IMPLIED, 2, 1, "TAY")                          \
+	X(0xBA, _tsx, M_IMPLIED, 2, 1, "TSX")                          \
+	X(0x8A, _txa, M_IMPLIED, 2, 1, "TXA")                          \
+	X(0x9A, _txs, M_IMPLIED, 2, 1, "TXS")                          \
+	X(0x98, _tya, M_IMPLIED, 2, 1, "TYA")                          \
+                                                                   \
+	X(0x8B, _xaa, M_IMMEDIATE, 2, 2, "*XAA")
+
+#endif	// GUARD_NESINC_CPU_OPS_H_
@@ -5,7 +5,7 @@
 #include "common.h"
 #include "screen.h"
 
-#define FRAME_SIZE (SCR_W * SCR_H * 3)
+#define FRAME_SIZE (SCR_W * SCR_H)
 
 static const SDL_Color SYS_PAL[64] = {
 	{0x80, 0x80, 0x80, 0xFF}, {0x00, 0x3D, 0xA6, 0xFF},
@@ -41,13 +41,58 @@ static const SDL_Color SYS_PAL[64] = {
 	{0x99, 0xFF, 0xFC, 0xFF}, {0xDD, 0xDD, 0xDD, 0xFF},
 	{0x11, 0x11, 0x11, 0xFF}, {0x11, 0x11, 0x11, 0xFF}};
 
+/* What the PPU outputs: a 6 bit colour for every pixel, and the PPUMASK
+ * emphasis bits (red, green, blue from bit 0 up) for every line. Turning that
+ * into RGB is left to whoever shows the frame
+ */
 typedef struct _Frame {
-	uint8_t data[FRAME_SIZE];
+	uint8_t pixels[FRAME_SIZE];
+	uint8_t emphasis[SCR_H];
 } Frame;
 
+#define FRAME_EMPHASES 8
+#define FRAME_COLORS 64
+
+/* Every colour under every emphasis, in the consumer's pixel format */
+typedef struct _FrameLUT {
+	uint32_t colors[FRAME_EMPHASES][FRAME_COLORS];
+} FrameLUT;
+
 void frameInit(Frame *frame);
 
-void frameSetPixel(Frame *frame, const size_t X, const size_t Y,
-				   SDL_Color color);
+/* SDL_PIXELFORMAT_ARGB8888 */
+void frameLUTInitARGB(FrameLUT *lut);
+/* 8 bit luma, in the low byte */
+void frameLUTInitGray(FrameLUT *lut);
+
+/* One lookup per pixel, through the line's emphasis row of LUT. OUT holds
+ * FRAME_SIZE pixels. The 8 bit one keeps the low byte of each entry
+ */
+void frameConvert32(const Frame *FRAME, const FrameLUT *LUT, uint32_t *out);
+void frameConvert8(const Frame *FRAME, const FrameLUT *LUT, uint8_t *out);
+
+/* Line kernels behind the conversions, each doing SCR_W pixels through one
+ * 64 entry row of a LUT. Like the tile decoders, the SIMD ones are picked at
+ * runtime: AVX2 gathers the 32 bit entries, and the 8 bit ones look up a
+ * byte table with PSHUFB
+ */
+typedef void (*FrameLine32Fn)(const uint8_t *PIXELS, const uint32_t *COLORS,
+							  uint32_t *out);
+typedef void (*FrameLine8Fn)(const uint8_t *PIXELS, const uint32_t *COLORS,
+							 uint8_t *out);
+
+typedef enum _FrameKernel {
+	FRAME_SCALAR,
+	FRAME_SSSE3,
+	FRAME_AVX2,
+	FRAME_KERNELS,
+} FrameKernel;
+
+/* KERNEL's line function, or NULL if this build or CPU can't run it. There's
+ * no SSSE3 one for 32 bit output, since it has no gather
+ */
+FrameLine32Fn frameKernel32(const FrameKernel KERNEL);
+FrameLine8Fn frameKernel8(const FrameKernel KERNEL);
+const char *frameKernelName(const FrameKernel KERNEL);
 
 #endif	// GUARD_NESINC_FRAME_H_
@@ -29,4 +29,7 @@ void joyInit(Joypad *joy);
 void joyWrite(Joypad *joy, const uint8_t VALUE);
 uint8_t joyRead(Joypad *joy);
 
+/* What joyRead would return, without shifting to the next button */
+uint8_t joyPeek(const Joypad *joy);
+
 #endif	// GUARD_NESINC_JOYPAD_H_
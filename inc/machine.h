@@ -0,0 +1,27 @@
+#ifndef GUARD_NESINC_MACHINE_H_
+#define GUARD_NESINC_MACHINE_H_
+
+#include "common.h"
+#include "cpu.h"
+#include "rom.h"
+
+/* A whole console: the CPU, and the bus, PPU and cartridge behind it
+ *
+ * Machines live on the heap and are built in place, so creating or resetting
+ * one never copies the bus (and the PPU and frame inside it) around
+ */
+typedef struct _Machine Machine;
+
+/* The machine keeps a copy of the ROM header, but the PRG, CHR and PRG RAM
+ * data it points to must outlive it
+ */
+Machine *machineCreate(const ROM *CART);
+void machineDestroy(Machine *machine);
+
+/* Powers the machine back on. Watches and the trace are kept */
+void machineReset(Machine *machine);
+
+CPU *machineCPU(Machine *machine);
+void machineRun(Machine *machine);
+
+#endif	// GUARD_NESINC_MACHINE_H_
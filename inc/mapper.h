@@ -0,0 +1,44 @@
+#ifndef GUARD_NESINC_MAPPER_H_
+#define GUARD_NESINC_MAPPER_H_
+
+#include "common.h"
+
+typedef struct _Bus Bus;
+
+/* Cartridge bank switching (NROM, MMC1, UxROM, CNROM and MMC3)
+ *
+ * A bank switch repoints the bus's PRG pages and the PPU's CHR banks, so it
+ * costs the same no matter how big the bank is, and reads never go through
+ * the mapper. Mappers that switch CHR or mirroring catch the PPU up first, so
+ * the lines drawn so far keep what they had
+ */
+typedef struct _Mapper {
+	uint8_t id;
+
+	/* MMC1: serial shift register, then control, CHR 0, CHR 1 and PRG */
+	uint8_t shift;
+	uint8_t shiftCount;
+	uint8_t regs[4];
+
+	/* MMC3: bank select, R0-R7 and the scanline counter */
+	uint8_t bankSelect;
+	uint8_t banks[8];
+
+	bool countsScanlines;
+	uint8_t irqLatch;
+	uint8_t irqCounter;
+	bool irqReload;
+	bool irqEnabled;
+} Mapper;
+
+bool mapperIsSupported(const uint8_t ID);
+
+/* Maps the power-on banks and hooks up the mapper's registers. The bus's PRG
+ * pages and PPU must be set up already
+ */
+void mapperInit(Bus *bus);
+
+/* Clocks the scanline counter, for mappers that have one */
+void mapperScanline(Bus *bus);
+
+#endif	// GUARD_NESINC_MAPPER_H_
@@ -12,11 +12,45 @@
 
 typedef struct _Frame Frame;
 
+/* CHR is mapped in 1KB banks, so mappers can switch them by repointing */
+#define PPU_CHR_BANK_SIZE 0x0400
+#define PPU_CHR_BANKS 8
+
+/* 16 byte tiles, decoded to one colour index (0-3) per pixel */
+#define PPU_TILES 512
+#define PPU_TILES_PER_BANK (PPU_CHR_BANK_SIZE / 16)
+
+/* The 2KB of VRAM holds two nametables of 32x30 tiles */
+#define PPU_NAMETABLES 2
+#define PPU_NAMETABLE_TILES 960
+
 typedef struct _PPU {
-	uint8_t *chrRom;
+	uint8_t *chrBanks[PPU_CHR_BANKS];
+	bool chrWritable; /* CHR RAM */
+
+	/* Decoded the first time they're drawn, and thrown away when the CHR
+	 * under them is written or switched out
+	 */
+	uint8_t tiles[PPU_TILES][64];
+	bool tileValid[PPU_TILES];
+
+	/* Set along with tileValid, until the background plane has caught up */
+	bool chrChanged[PPU_TILES];
+	bool chrChangedAny;
+
 	uint8_t palTable[32];
 	uint8_t vram[2048];
 
+	/* Both nametables, drawn ahead of time as palette entries (0-15), so the
+	 * palette itself is only looked up when a line is composed. A tile is
+	 * redrawn once its nametable or attribute byte, its CHR or the background
+	 * pattern table changes
+	 */
+	uint8_t bgPlane[PPU_NAMETABLES][SCR_H][SCR_W];
+	bool bgDirty[PPU_NAMETABLES][PPU_NAMETABLE_TILES];
+	bool bgDirtyAny;
+	uint16_t bgPlaneTiles; /* First tile of the pattern table it was drawn with */
+
 	uint8_t oamAddr;
 	uint8_t oam[256];
 
@@ -32,6 +66,7 @@ typedef struct _PPU {
 
 	uint16_t scanline;
 	size_t cycles;
+	uint16_t frameScrollY; /* Vertical scroll for the frame being drawn */
 
 	bool nmiInterrupt;
 	Frame frame;
@@ -41,6 +76,17 @@ void ppuInit(PPU *ppu, uint8_t *chrRom, const Mirroring MIRRORING);
 void ppuInitEmpty(PPU *ppu);
 void ppuInitEmptyVertical(PPU *ppu);
 
+/* Pattern table memory at ADDRESS ($0000-$1FFF) */
+static inline uint8_t *ppuChr(PPU *ppu, const uint16_t ADDRESS) {
+	return &ppu->chrBanks[ADDRESS >> 10][ADDRESS & (PPU_CHR_BANK_SIZE - 1)];
+}
+
+/* Points 1KB CHR slot SLOT at BANK */
+void ppuMapChr(PPU *ppu, const uint8_t SLOT, uint8_t *bank);
+
+/* Tile TILE ($0000-$1FFF / 16), as 8 rows of 8 colour indices */
+const uint8_t *ppuTile(PPU *ppu, const uint16_t TILE);
+
 void ppuVramIncrement(PPU *ppu);
 
 void ppuWrite(PPU *ppu, const uint8_t VALUE);
@@ -58,7 +104,18 @@ uint8_t ppuRead(PPU *ppu);
 uint8_t ppuReadOAM(PPU *ppu);
 StatusReg ppuReadStatus(PPU *ppu);
 
-bool ppuTick(PPU *ppu, const uint8_t CYCLES);
-void ppuRender(PPU *ppu);
+/* Debug access for tooling. None of these change any state */
+
+/* PPU memory at ADDRESS, with the same mirroring the PPU sees */
+uint8_t ppuPeek(const PPU *ppu, const uint16_t ADDRESS);
+void ppuPeekRange(const PPU *ppu, const uint16_t START, uint8_t *out,
+				  const size_t COUNT);
+
+/* What reading PPUDATA ($2007) would return */
+uint8_t ppuPeekData(const PPU *ppu);
+void ppuPeekOAM(const PPU *ppu, uint8_t out[256]);
+
+bool ppuTick(PPU *ppu, const size_t CYCLES);
+size_t ppuCyclesUntil(PPU *ppu, const uint16_t SCANLINE);
 
 #endif	// GUARD_NESINC_PPU_H_
@@ -0,0 +1,30 @@
+#ifndef GUARD_NESINC_PPU_TILE_H_
+#define GUARD_NESINC_PPU_TILE_H_
+
+#include "common.h"
+
+/* Bitplane decoding
+ *
+ * A tile is 8 rows of two bitplanes: 8 bytes of low bits, then 8 of high ones,
+ * leftmost pixel in bit 7. Decoding expands that to one colour index (0-3) per
+ * pixel, row by row. The SIMD kernels do a whole row per lane group instead of
+ * a bit at a time, and are picked at runtime from what the CPU supports
+ */
+
+typedef void (*TileDecodeFn)(const uint8_t PLANES[16], uint8_t out[64]);
+
+typedef enum _TileKernel {
+	TILE_SCALAR,
+	TILE_SSE2,
+	TILE_AVX2,
+	TILE_KERNELS,
+} TileKernel;
+
+/* KERNEL's decode function, or NULL if this build or CPU can't run it */
+TileDecodeFn tileKernel(const TileKernel KERNEL);
+const char *tileKernelName(const TileKernel KERNEL);
+
+/* Decodes with the fastest kernel there is */
+void tileDecode(const uint8_t PLANES[16], uint8_t out[64]);
+
+#endif	// GUARD_NESINC_PPU_TILE_H_
@@ -7,6 +7,8 @@ typedef enum {
 	VERTICAL,
 	HORIZONTAL,
 	FOUR_SCREEN,
+	SINGLE_SCREEN_LOWER,
+	SINGLE_SCREEN_UPPER,
 } Mirroring;
 
 typedef struct _ROM {
@@ -15,6 +17,13 @@ typedef struct _ROM {
 
 	size_t chrSize;
 	uint8_t *chrRom;
+	bool chrRam; /* No CHR ROM, so 8KB of CHR RAM was allocated instead */
+
+	/* PRG RAM ($6000-$7FFF). With a battery, it's mapped from a .sav file */
+	size_t prgRamSize;
+	uint8_t *prgRam;
+	bool battery;
+	bool prgRamMapped;
 
 	uint8_t mapper;
 	Mirroring mirroring;
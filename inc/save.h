@@ -0,0 +1,18 @@
+#ifndef GUARD_NESINC_SAVE_H_
+#define GUARD_NESINC_SAVE_H_
+
+#include "common.h"
+
+/* Battery-backed RAM, kept in a .sav file mapped straight into memory
+ *
+ * The emulator writes to the mapping like any other RAM, and the OS takes
+ * care of getting it to disk, even if the emulator crashes
+ */
+
+/* Maps SIZE bytes of PATH, creating or growing the file if needed. Returns
+ * NULL if it can't be mapped
+ */
+uint8_t *saveMap(const char *PATH, const size_t SIZE);
+void saveUnmap(uint8_t *data, const size_t SIZE);
+
+#endif	// GUARD_NESINC_SAVE_H_
@@ -0,0 +1,43 @@
+#ifndef GUARD_NESINC_SCHEDULER_H_
+#define GUARD_NESINC_SCHEDULER_H_
+
+#include "common.h"
+
+/* Scheduler for timed events, driven by the bus clock (in CPU cycles)
+ *
+ * The CPU runs freely until the bus clock reaches the earliest pending
+ * event, instead of checking on every component after each instruction
+ */
+
+#define SCHED_NEVER SIZE_MAX
+
+typedef enum {
+	EVENT_VBLANK,	 /* The PPU reaches scanline 241 */
+	EVENT_FRAME_END, /* The PPU wraps back to scanline 0 */
+	EVENT_SCANLINE,	 /* A12 rises on a rendering scanline (MMC3 counter) */
+
+	EVENT_COUNT,
+} EventType;
+
+typedef struct _Event {
+	size_t time;
+	EventType type;
+} Event;
+
+/* Pending events, sorted by time. Each type is pending at most once */
+typedef struct _Scheduler {
+	Event queue[EVENT_COUNT];
+	uint8_t count;
+
+	size_t next; /* Time of the earliest event, or SCHED_NEVER */
+} Scheduler;
+
+void schedInit(Scheduler *sched);
+
+void schedAdd(Scheduler *sched, const EventType TYPE, const size_t TIME);
+void schedCancel(Scheduler *sched, const EventType TYPE);
+
+/* Pops the earliest event if it's due by NOW */
+bool schedPop(Scheduler *sched, const size_t NOW, EventType *type);
+
+#endif	// GUARD_NESINC_SCHEDULER_H_
@@ -9,6 +9,8 @@
 
 #define SCR_SCALE 2.0f
 
+typedef struct _Frame Frame;
+
 typedef struct _Screen {
 	SDL_Window *window;
 	SDL_Renderer *renderer;
@@ -20,4 +22,7 @@ extern Screen gScreen;
 void screenInit(Screen *screen);
 void screenFree(Screen *screen);
 
+/* Converts FRAME to the texture's format and shows it */
+void screenPresent(Screen *screen, const Frame *FRAME);
+
 #endif	// GUARD_NESINC_SCREEN_H_
@@ -0,0 +1,52 @@
+#ifndef GUARD_NESINC_TRACE_H_
+#define GUARD_NESINC_TRACE_H_
+
+#include "common.h"
+
+/* Execution trace
+ *
+ * A ring of compact records of the CPU state before each instruction. Nothing
+ * is formatted until it's asked for (see cpuTraceFormat), so keeping it on
+ * only costs a few stores per instruction
+ */
+
+#define TRACE_SIZE 4096		/* Records kept, must be a power of two */
+#define TRACE_DUMP_LAST 32	/* Records dumped after a crash or KIL */
+
+typedef struct _TraceRecord {
+	size_t cycles;
+
+	uint16_t pc;
+	uint8_t opcode;
+	uint8_t operands[2];
+
+	uint8_t regA;
+	uint8_t regX;
+	uint8_t regY;
+	uint8_t stack;
+
+	/* Raw status bits, with zero and negative still in their lazy form */
+	uint8_t status;
+	uint8_t zeroResult;
+	uint8_t negResult;
+} TraceRecord;
+
+typedef struct _Trace {
+	TraceRecord records[TRACE_SIZE];
+	size_t count; /* Records ever taken */
+} Trace;
+
+Trace *traceCreate(void);
+void traceDestroy(Trace *trace);
+
+/* Returns the slot for the next record, overwriting the oldest one */
+static inline TraceRecord *traceNext(Trace *trace) {
+	return &trace->records[trace->count++ & (TRACE_SIZE - 1)];
+}
+
+/* Returns the record taken AGO records before the latest one, or NULL if it's
+ * been overwritten (or never taken)
+ */
+const TraceRecord *traceGet(const Trace *TRACE, const size_t AGO);
+
+#endif	// GUARD_NESINC_TRACE_H_
@@ -0,0 +1,57 @@
+#ifndef GUARD_NESINC_WATCH_H_
+#define GUARD_NESINC_WATCH_H_
+
+#include "common.h"
+#include "cpu.h"
+
+/* Memory access instrumentation
+ *
+ * Callbacks are registered for reads, writes and/or instruction fetches on an
+ * address range. A per-page map of the watched kinds keeps unwatched pages
+ * down to a single lookup, and with nothing registered the CPU only checks
+ * for a NULL list
+ */
+
+#define WATCH_MAX 16
+
+typedef enum {
+	WATCH_READ = 1 << 0,
+	WATCH_WRITE = 1 << 1,
+	WATCH_EXEC = 1 << 2,
+} WatchKind;
+
+/* VALUE is the byte read or written, or the opcode for WATCH_EXEC */
+typedef void (*WatchFn)(CPU *cpu, const WatchKind KIND, const uint16_t ADDRESS,
+						const uint8_t VALUE, void *data);
+
+typedef struct _Watch {
+	WatchFn fn;
+	void *data;
+
+	uint16_t start;
+	uint16_t end; /* Inclusive */
+	uint8_t kinds;
+} Watch;
+
+struct _WatchList {
+	uint8_t pages[256]; /* Kinds watched anywhere in each 256 byte page */
+	Watch watches[WATCH_MAX];
+
+	/* Callbacks can remove watches, the last one included. The list is only
+	 * freed once every watchNotify walking it has returned
+	 */
+	uint8_t notifying;
+	bool freePending;
+};
+
+/* Returns an ID for watchRemove, or -1 if there's no room left */
+int watchAdd(CPU *cpu, const uint8_t KINDS, const uint16_t START,
+			 const uint16_t END, WatchFn fn, void *data);
+/* Both are safe to call from inside a callback */
+void watchRemove(CPU *cpu, const int ID);
+void watchClear(CPU *cpu);
+
+void watchNotify(CPU *cpu, const WatchKind KIND, const uint16_t ADDRESS,
+				 const uint8_t VALUE);
+
+#endif	// GUARD_NESINC_WATCH_H_
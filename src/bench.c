@@ -0,0 +1,217 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu.h"
+#include "frame.h"
+#include "machine.h"
+#include "ppu_tile.h"
+#include "rom.h"
+
+#define NES_CPU_HZ 1789773.0
+
+/* MMC3 cart with 32KB of PRG ROM. The code lives in the fixed bank at $E000:
+ * it turns on rendering, sets the counter to fire on every scanline, then
+ * spins on some busywork. The IRQ handler acknowledges and counts, and the NMI
+ * handler stops the run after BENCH_FRAMES frames
+ */
+#define BENCH_FRAMES 120
+#define BENCH_IRQ_ENABLE 0x17 /* Low byte of the STA $E001 that enables IRQs */
+
+static const uint8_t BENCH_MAIN[0x25] = {
+	0xA9, BENCH_FRAMES, 0x85, 0x12, /* Frames left */
+	0xA9, 0x88, 0x8D, 0x00, 0x20,	/* NMI on, sprites at $1000 */
+	0xA9, 0x18, 0x8D, 0x01, 0x20,	/* Rendering on */
+	0xA9, 0x00, 0x8D, 0x00, 0xC0,	/* IRQ on every scanline */
+	0x8D, 0x01, 0xC0,
+	0x8D, 0x01, 0xE0,				/* Enable (or $E000 to disable) */
+	0x58,
+	0xE8, 0xBD, 0x00, 0x02, 0x65, 0x10, 0x85, 0x10, 0x4C, 0x1A, 0xE0,
+};
+
+static const uint8_t BENCH_IRQ[15] = {
+	0x48, 0x8D, 0x00, 0xE0, 0x8D, 0x01, 0xE0, /* Acknowledge */
+	0xE6, 0x11, 0xD0, 0x02, 0xE6, 0x13,		  /* Count */
+	0x68, 0x40,
+};
+
+static const uint8_t BENCH_NMI[6] = {0xC6, 0x12, 0xD0, 0x01, 0x00, 0x40};
+
+static void _noFrame(PPU *ppu, Joypad *joy1, Joypad *joy2) {
+	UNUSED(ppu);
+	UNUSED(joy1);
+	UNUSED(joy2);
+}
+
+static void _benchScanlineIRQ(const char *NAME, const bool IRQ) {
+	static uint8_t raw[16 + 0x8000 + 0x2000];
+	memset(raw, 0, sizeof(raw));
+
+	const uint8_t HEADER[8] = {'N', 'E', 'S', 0x1A, 2, 1, 0x40, 0x00};
+	memcpy(raw, HEADER, 8);
+
+	uint8_t *fixed = raw + 16 + 0x6000;
+	memcpy(fixed, BENCH_MAIN, sizeof(BENCH_MAIN));
+	memcpy(fixed + 0x40, BENCH_IRQ, sizeof(BENCH_IRQ));
+	memcpy(fixed + 0x80, BENCH_NMI, sizeof(BENCH_NMI));
+
+	fixed[BENCH_IRQ_ENABLE] = IRQ ? 0x01 : 0x00;
+
+	const uint8_t VECTORS[6] = {0x80, 0xE0, 0x00, 0xE0, 0x40, 0xE0};
+	memcpy(fixed + 0x1FFA, VECTORS, 6);
+
+	ROM rom;
+	romInit(&rom, raw);
+
+	Machine *machine = machineCreate(&rom);
+	CPU *cpu = machineCPU(machine);
+	cpu->bus.callback = _noFrame;
+
+	const clock_t START = clock();
+	machineRun(machine);
+	const double SECONDS = (double)(clock() - START) / CLOCKS_PER_SEC;
+
+	const double CYCLES = (double)cpu->bus.cycles;
+	const unsigned IRQS =
+		(unsigned)(busReadRAM(&cpu->bus, 0x11) | busReadRAM(&cpu->bus, 0x13) << 8);
+
+	printf("%-24s %3d frames, %5u IRQs: %7.2f MHz (%.1fx real time)\n", NAME,
+		   BENCH_FRAMES, IRQS, CYCLES / SECONDS / 1e6,
+		   CYCLES / SECONDS / NES_CPU_HZ);
+
+	machineDestroy(machine);
+	romFree(&rom);
+}
+
+/* Decodes 8KB of made up CHR over and over with each tile kernel. The scalar
+ * one is the bit at a time loop the renderer used to run
+ */
+#define BENCH_TILE_PASSES 4000
+
+static void _benchTileDecode(void) {
+	static uint8_t chr[512 * 16];
+	uint32_t seed = 0x1234567;
+
+	for( size_t i = 0; i < sizeof(chr); ++i ) {
+		seed = seed * 1103515245 + 12345;
+		chr[i] = (uint8_t)(seed >> 16);
+	}
+
+	double scalarRate = 0.0;
+
+	for( int kernel = TILE_SCALAR; kernel < TILE_KERNELS; ++kernel ) {
+		const TileDecodeFn DECODE = tileKernel((TileKernel)kernel);
+		const char *NAME = tileKernelName((TileKernel)kernel);
+
+		if( DECODE == NULL ) {
+			printf("Tile decode, %-12s unsupported\n", NAME);
+			continue;
+		}
+
+		uint8_t out[64];
+		unsigned sum = 0;
+
+		const clock_t START = clock();
+		for( size_t pass = 0; pass < BENCH_TILE_PASSES; ++pass ) {
+			for( size_t tile = 0; tile < 512; ++tile ) {
+				DECODE(&chr[tile * 16], out);
+				sum += out[pass & 63];
+			}
+		}
+		const double SECONDS = (double)(clock() - START) / CLOCKS_PER_SEC;
+
+		const double RATE = 512.0 * BENCH_TILE_PASSES / SECONDS / 1e6;
+		if( kernel == TILE_SCALAR ) {
+			scalarRate = RATE;
+		}
+
+		printf("Tile decode, %-12s %7.2f Mtiles/s (%.1fx scalar) [%u]\n", NAME,
+			   RATE, RATE / scalarRate, sum);
+	}
+}
+
+/* Converts a made up frame over and over with each line kernel, to ARGB and to
+ * 8 bit gray
+ */
+#define BENCH_FRAME_PASSES 2000
+
+static void _benchFrameConvert(void) {
+	static Frame frame;
+	uint32_t seed = 0x1234567;
+
+	for( size_t i = 0; i < FRAME_SIZE; ++i ) {
+		seed = seed * 1103515245 + 12345;
+		frame.pixels[i] = (uint8_t)(seed >> 16) & 0x3F;
+	}
+	for( size_t y = 0; y < SCR_H; ++y ) {
+		frame.emphasis[y] = (uint8_t)(y & 7);
+	}
+
+	static FrameLUT argb, gray;
+	frameLUTInitARGB(&argb);
+	frameLUTInitGray(&gray);
+
+	static uint32_t out32[FRAME_SIZE];
+	static uint8_t out8[FRAME_SIZE];
+
+	double scalar32 = 0.0, scalar8 = 0.0;
+
+	for( int kernel = FRAME_SCALAR; kernel < FRAME_KERNELS; ++kernel ) {
+		const FrameLine32Fn LINE32 = frameKernel32((FrameKernel)kernel);
+		const FrameLine8Fn LINE8 = frameKernel8((FrameKernel)kernel);
+		const char *NAME = frameKernelName((FrameKernel)kernel);
+
+		if( LINE32 != NULL ) {
+			const clock_t START = clock();
+			for( size_t pass = 0; pass < BENCH_FRAME_PASSES; ++pass ) {
+				for( size_t y = 0; y < SCR_H; ++y ) {
+					LINE32(&frame.pixels[y * SCR_W],
+						   argb.colors[frame.emphasis[y]], &out32[y * SCR_W]);
+				}
+			}
+			const double SECONDS = (double)(clock() - START) / CLOCKS_PER_SEC;
+
+			const double RATE = BENCH_FRAME_PASSES / SECONDS;
+			if( kernel == FRAME_SCALAR ) {
+				scalar32 = RATE;
+			}
+
+			printf("Frame to ARGB, %-10s %7.0f frames/s (%.1fx scalar) [%u]\n",
+				   NAME, RATE, RATE / scalar32, out32[FRAME_SIZE / 2]);
+		}
+
+		if( LINE8 != NULL ) {
+			const clock_t START = clock();
+			for( size_t pass = 0; pass < BENCH_FRAME_PASSES; ++pass ) {
+				for( size_t y = 0; y < SCR_H; ++y ) {
+					LINE8(&frame.pixels[y * SCR_W],
+						  gray.colors[frame.emphasis[y]], &out8[y * SCR_W]);
+				}
+			}
+			const double SECONDS = (double)(clock() - START) / CLOCKS_PER_SEC;
+
+			const double RATE = BENCH_FRAME_PASSES / SECONDS;
+			if( kernel == FRAME_SCALAR ) {
+				scalar8 = RATE;
+			}
+
+			printf("Frame to gray, %-10s %7.0f frames/s (%.1fx scalar) [%u]\n",
+				   NAME, RATE, RATE / scalar8, out8[FRAME_SIZE / 2]);
+		}
+	}
+}
+
+void benchRun(void) {
+	printf("\nStarting benchmarks...\n");
+#ifndef __OPTIMIZE__
+	printf("Unoptimised build, the numbers won't match a release one\n");
+#endif
+
+	_benchScanlineIRQ("MMC3, IRQs off", false);
+	_benchScanlineIRQ("MMC3, IRQ every scanline", true);
+
+	_benchTileDecode();
+	_benchFrameConvert();
+}
@@ -14,41 +14,72 @@
 #define RAM_ADDRESS_SPACE 0x07FF
 #define PPU_REGISTERS_ADDRESS_SPACE 0x2007
 
-static uint8_t _readPrgRom(Bus *bus, uint16_t address) {
-	address -= 0x8000;
-	if( (bus->rom.prgSize == 0x4000) && (address >= 0x4000) ) {
-		address %= 0x4000;
+/* Schedules the next vblank and frame end, based on where the PPU is now */
+static void _schedulePPU(Bus *bus) {
+	PPU *ppu = &bus->ppu;
+
+	/* Rounded up, as the PPU runs 3 cycles for each CPU one */
+	const size_t VBLANK = (ppuCyclesUntil(ppu, 241) + 2) / 3;
+	const size_t FRAME_END = (ppuCyclesUntil(ppu, 262) + 2) / 3;
+
+	schedAdd(&bus->sched, EVENT_VBLANK, bus->ppuCycles + VBLANK);
+	schedAdd(&bus->sched, EVENT_FRAME_END, bus->ppuCycles + FRAME_END);
+}
+
+/* MMC3's counter is clocked when A12 rises at dot 260 of each rendering
+ * scanline (0-239 and the pre-render one). The PPU always runs 3 cycles per
+ * CPU cycle, so those happen at fixed times and don't need the PPU caught up.
+ * Clocks that were run past (e.g. during a DMA) are caught up here
+ */
+static void _runScanlines(Bus *bus) {
+	const size_t NOW = bus->cycles * 3;
+
+	while( bus->scanlineTime <= NOW ) {
+		mapperScanline(bus);
+
+		const size_t SCANLINE = (bus->scanlineTime / 341) % 262;
+		bus->scanlineTime += (SCANLINE == 239) ? 22 * 341 : 341;
 	}
 
-	return bus->rom.prgRom[address];
+	schedAdd(&bus->sched, EVENT_SCANLINE, (bus->scanlineTime + 2) / 3);
 }
 
-void busInit(Bus *bus, ROM rom, BUS_CALLBACK_FN) {
-	memset(bus->cpuVRAM, 0, 2048);
+static void _runEvents(Bus *bus) {
+	EventType type;
 
-	bus->rom = rom;
-	bus->cycles = 0;
-	bus->callback = callback;
+	while( schedPop(&bus->sched, bus->cycles, &type) ) {
+		switch( type ) {
+			case EVENT_VBLANK:
+			case EVENT_FRAME_END:
+				busSyncPPU(bus);
+				_schedulePPU(bus);
+				break;
 
-	ppuInit(&bus->ppu, bus->rom.chrRom, bus->rom.mirroring);
+			case EVENT_SCANLINE:
+				_runScanlines(bus);
+				break;
 
-	joyInit(&bus->joy1);
-	joyInit(&bus->joy2);
+			default:
+				break;
+		}
+	}
 }
 
-uint8_t busRead(Bus *bus, const uint16_t ADDRESS) {
-	switch( ADDRESS ) {
-		case 0 ... RAM_MIRRORS_END:
-			return bus->cpuVRAM[ADDRESS & RAM_ADDRESS_SPACE];
+/* Mirrors the PPU's NMI output into the CPU's pending events */
+static void _syncNMI(Bus *bus) {
+	if( bus->ppu.nmiInterrupt ) {
+		*bus->pendingEvents |= PENDING_NMI;
+	} else {
+		*bus->pendingEvents &= (uint8_t)~PENDING_NMI;
+	}
+}
 
-		case 0x2000:
-		case 0x2001:
-		case 0x2003:
-		case 0x2005:
-		case 0x2006:
-		case 0x4014:
-			return 0;
+/* Page handlers */
 
+static uint8_t _readPPU(Bus *bus, const uint16_t ADDRESS) {
+	busSyncPPU(bus);
+
+	switch( ADDRESS & PPU_REGISTERS_ADDRESS_SPACE ) {
 		case 0x2002: {
 			const uint8_t RESULT = bus->ppu.status.bits;
 			bus->ppu.status.vblankStarted = 0;
@@ -61,38 +92,19 @@ uint8_t busRead(Bus *bus, const uint16_t ADDRESS) {
 		case 0x2007:
 			return ppuRead(&bus->ppu);
 
-		case 0x2008 ... PPU_REGISTERS_MIRRORS_END:
-			return busRead(bus, ADDRESS & PPU_REGISTERS_ADDRESS_SPACE);
-
-		case 0x4016:
-			return joyRead(&bus->joy1);
-
-		case 0x4017:
-			return joyRead(&bus->joy2);
-
-		case 0x8000 ... 0xFFFF:
-			return _readPrgRom(bus, ADDRESS);
-
 		default:
 			return 0;
 	}
 }
 
-uint16_t busRead16(Bus *bus, const uint16_t ADDRESS) {
-	const uint16_t LO = (uint16_t)busRead(bus, ADDRESS);
-	const uint16_t HI = (uint16_t)busRead(bus, ADDRESS + 1);
-
-	return (HI << 8) | LO;
-}
-
-void busWrite(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
-	switch( ADDRESS ) {
-		case 0 ... RAM_MIRRORS_END:
-			bus->cpuVRAM[ADDRESS & RAM_ADDRESS_SPACE] = VALUE;
-			return;
+static void _writePPU(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	busSyncPPU(bus);
 
+	switch( ADDRESS & PPU_REGISTERS_ADDRESS_SPACE ) {
 		case 0x2000:
+			/* Turning NMIs on during vblank raises one straight away */
 			ppuWriteControl(&bus->ppu, VALUE);
+			_syncNMI(bus);
 			return;
 
 		case 0x2001:
@@ -119,38 +131,262 @@ void busWrite(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
 			ppuWrite(&bus->ppu, VALUE);
 			return;
 
-		case 0x2008 ... PPU_REGISTERS_MIRRORS_END:
-			busWrite(bus, ADDRESS & 0x2007, VALUE);
+		default:
 			return;
+	}
+}
 
-		case 0x4000 ... 0x4013:
-		case 0x4015: /* APU */
-			return;
+/* Copies a page into OAM. RAM and ROM pages are copied straight from their
+ * host pointer; anything else is read a byte at a time
+ *
+ * The CPU is halted for 513 cycles, plus one more to line up with a read
+ * cycle if the write landed on an odd one. The bus clock is still at the
+ * start of the writing instruction here, which for the usual 4 cycle store
+ * has the same parity as its last cycle
+ */
+static void _oamDMA(Bus *bus, const uint8_t PAGE) {
+	busSyncPPU(bus);
+
+	const uint8_t *SOURCE = bus->pages[PAGE].read;
+
+	if( SOURCE != NULL ) {
+		ppuWriteOAMDMA(&bus->ppu, SOURCE);
+	} else {
+		uint8_t buffer[256];
+		const uint16_t HI = (uint16_t)(PAGE << 8);
+
+		for( uint16_t i = 0; i < 256; ++i ) {
+			buffer[i] = busRead(bus, HI | i);
+		}
 
-		case 0x4014: {
-			uint8_t buffer[256] = {0};
-			const uint16_t HI = VALUE << 8;
+		ppuWriteOAMDMA(&bus->ppu, buffer);
+	}
 
-			for( uint16_t i = 0; i < 256; ++i ) {
-				buffer[i] = busRead(bus, HI + i);
-			}
+	bus->cycles += BUS_DMA_CYCLES + (bus->cycles & 1);
+}
 
-			ppuWriteOAMDMA(&bus->ppu, buffer);
-		}
+/* APU and I/O registers ($4000-$40FF) */
+static uint8_t _readIO(Bus *bus, const uint16_t ADDRESS) {
+	switch( ADDRESS ) {
+		case 0x4016:
+			return joyRead(&bus->joy1);
+
+		case 0x4017:
+			return joyRead(&bus->joy2);
+
+		default:
+			return 0;
+	}
+}
+
+/* Peeks see what a read would, without the read's side effects. They don't
+ * catch the PPU up either, as that can run the frame callback
+ */
+
+static uint8_t _peekPPU(const Bus *bus, const uint16_t ADDRESS) {
+	switch( ADDRESS & PPU_REGISTERS_ADDRESS_SPACE ) {
+		case 0x2002:
+			return bus->ppu.status.bits;
+
+		case 0x2004:
+			return bus->ppu.oam[bus->ppu.oamAddr];
+
+		case 0x2007:
+			return ppuPeekData(&bus->ppu);
+
+		default:
+			return 0;
+	}
+}
+
+static uint8_t _peekIO(const Bus *bus, const uint16_t ADDRESS) {
+	switch( ADDRESS ) {
+		case 0x4016:
+			return joyPeek(&bus->joy1);
+
+		case 0x4017:
+			return joyPeek(&bus->joy2);
+
+		default:
+			return 0;
+	}
+}
+
+static void _writeIO(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	switch( ADDRESS ) {
+		case 0x4014:
+			_oamDMA(bus, VALUE);
 			return;
 
 		case 0x4016:
 			joyWrite(&bus->joy1, VALUE);
-			break;
+			return;
 
 		case 0x4017:
 			joyWrite(&bus->joy2, VALUE);
-			break;
+			return;
+
+		default: /* APU */
+			return;
+	}
+}
+
+static uint8_t _readUnmapped(Bus *bus, const uint16_t ADDRESS) {
+	UNUSED(bus);
+	UNUSED(ADDRESS);
+
+	return 0;
+}
+
+static void _writeUnmapped(Bus *bus, const uint16_t ADDRESS,
+						   const uint8_t VALUE) {
+	UNUSED(bus);
+	UNUSED(ADDRESS);
+	UNUSED(VALUE);
+}
+
+static void _mapHandlers(Bus *bus, const uint16_t START, const uint16_t END,
+						 BusReadFn readFn, BusWriteFn writeFn) {
+	for( uint16_t page = START >> 8; page <= (END >> 8); ++page ) {
+		bus->pages[page] = (BusPage){NULL, NULL, readFn, writeFn};
+	}
+}
+
+static void _mapMemory(Bus *bus) {
+	_mapHandlers(bus, 0x0000, 0xFFFF, _readUnmapped, _writeUnmapped);
+
+	for( uint16_t page = RAM >> 8; page <= (RAM_MIRRORS_END >> 8); ++page ) {
+		uint8_t *host = &bus->cpuVRAM[(page << 8) & RAM_ADDRESS_SPACE];
+
+		bus->pages[page].read = host;
+		bus->pages[page].write = host;
+	}
+
+	_mapHandlers(bus, PPU_REGISTERS, PPU_REGISTERS_MIRRORS_END, _readPPU,
+				 _writePPU);
+	_mapHandlers(bus, 0x4000, 0x40FF, _readIO, _writeIO);
+	/* The first 8KB of PRG RAM, if the cartridge has any */
+	if( bus->rom.prgRam != NULL ) {
+		for( uint16_t page = 0x60; page < 0x80; ++page ) {
+			uint8_t *host = &bus->rom.prgRam[(size_t)(page - 0x60) << 8];
+
+			bus->pages[page].read = host;
+			bus->pages[page].write = host;
+		}
+	}
+
+	/* PRG ROM pages are pointed at their banks by the mapper. Writes to them
+	 * are ignored, unless the mapper has registers there
+	 */
+	_mapHandlers(bus, 0x8000, 0xFFFF, _readUnmapped, _writeUnmapped);
+}
+
+void busInit(Bus *bus, const ROM *CART, uint8_t *pending, BUS_CALLBACK_FN) {
+	memset(bus->cpuVRAM, 0, 2048);
+
+	bus->pendingEvents = pending;
+	*bus->pendingEvents = 0;
+
+	bus->rom = *CART;
+	bus->cycles = 0;
+	bus->ppuCycles = 0;
+	bus->callback = callback;
+
+	for( uint8_t i = 0; i < BUS_PRG_WINDOWS; ++i ) {
+		bus->prgStamps[i] = 1;
+	}
+
+	_mapMemory(bus);
+
+	ppuInit(&bus->ppu, bus->rom.chrRom, bus->rom.mirroring);
+	mapperInit(bus);
+
+	schedInit(&bus->sched);
+	_schedulePPU(bus);
+
+	bus->irqLines = 0;
+	bus->irqMasked = true; /* The CPU comes out of reset with I set */
+	bus->scanlineTime = 260;
+
+	if( bus->mapper.countsScanlines ) {
+		_runScanlines(bus);
+	}
+
+	joyInit(&bus->joy1);
+	joyInit(&bus->joy2);
+}
+
+uint8_t busRead(Bus *bus, const uint16_t ADDRESS) {
+	const BusPage *PAGE = &bus->pages[ADDRESS >> 8];
+
+	if( PAGE->read != NULL ) {
+		return PAGE->read[ADDRESS & 0xFF];
+	}
+
+	return PAGE->readFn(bus, ADDRESS);
+}
+
+/* Every other handler reads as open bus, which has nothing to change */
+uint8_t busPeek(const Bus *bus, const uint16_t ADDRESS) {
+	const BusPage *PAGE = &bus->pages[ADDRESS >> 8];
+
+	if( PAGE->read != NULL ) {
+		return PAGE->read[ADDRESS & 0xFF];
+	}
+
+	if( PAGE->readFn == _readPPU ) {
+		return _peekPPU(bus, ADDRESS);
+	}
 
-		case 0x8000 ... 0xFFFF:
-			errPrint(C_RED, "Attempted to write to ROM @ %04X\n", ADDRESS);
-			exit(4);
+	if( PAGE->readFn == _readIO ) {
+		return _peekIO(bus, ADDRESS);
 	}
+
+	return 0;
+}
+
+/* Pages with a host pointer are copied whole, and wrap around at $FFFF */
+void busPeekRange(const Bus *bus, const uint16_t START, uint8_t *out,
+				  const size_t COUNT) {
+	size_t done = 0;
+
+	while( done < COUNT ) {
+		const uint16_t ADDRESS = (uint16_t)(START + done);
+		const BusPage *PAGE = &bus->pages[ADDRESS >> 8];
+
+		size_t run = BUS_PAGE_SIZE - (ADDRESS & 0xFF);
+		if( run > COUNT - done ) {
+			run = COUNT - done;
+		}
+
+		if( PAGE->read != NULL ) {
+			memcpy(&out[done], &PAGE->read[ADDRESS & 0xFF], run);
+		} else {
+			for( size_t i = 0; i < run; ++i ) {
+				out[done + i] = busPeek(bus, (uint16_t)(ADDRESS + i));
+			}
+		}
+
+		done += run;
+	}
+}
+
+uint16_t busRead16(Bus *bus, const uint16_t ADDRESS) {
+	const uint16_t LO = (uint16_t)busRead(bus, ADDRESS);
+	const uint16_t HI = (uint16_t)busRead(bus, ADDRESS + 1);
+
+	return (HI << 8) | LO;
+}
+
+void busWrite(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	const BusPage *PAGE = &bus->pages[ADDRESS >> 8];
+
+	if( PAGE->write != NULL ) {
+		PAGE->write[ADDRESS & 0xFF] = VALUE;
+		return;
+	}
+
+	PAGE->writeFn(bus, ADDRESS, VALUE);
 }
 
 void busWrite16(Bus *bus, const uint16_t ADDRESS, const uint16_t VALUE) {
@@ -161,7 +397,27 @@ void busWrite16(Bus *bus, const uint16_t ADDRESS, const uint16_t VALUE) {
 void busTick(Bus *bus, const uint8_t CYCLES) {
 	bus->cycles += CYCLES;
 
-	if( ppuTick(&bus->ppu, CYCLES * 3) ) {
+	if( bus->cycles >= bus->sched.next ) {
+		_runEvents(bus);
+	}
+}
+
+/* The PPU is only caught up when something can observe or change it: its
+ * registers being accessed, a mapper switching what it sees, or one of its
+ * events coming due
+ */
+void busSyncPPU(Bus *bus) {
+	const size_t CYCLES = (bus->cycles - bus->ppuCycles) * 3;
+	bus->ppuCycles = bus->cycles;
+
+	const bool FRAME_DONE = ppuTick(&bus->ppu, CYCLES);
+	_syncNMI(bus);
+
+	if( FRAME_DONE ) {
 		bus->callback(&bus->ppu, &bus->joy1, &bus->joy2);
 	}
 }
+
+void busInvalidatePrgWindow(Bus *bus, const uint8_t WINDOW) {
+	++bus->prgStamps[WINDOW];
+}
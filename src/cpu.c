@@ -1,51 +1,45 @@
 #include "cpu.h"
 
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include "SDL2/SDL.h"
+#include "cpu_alu.h"
+#include "cpu_ops.h"
 #include "error.h"
 #include "frame.h"
 #include "screen.h"
+#include "trace.h"
+#include "watch.h"
 
-typedef enum {
-	M_IMMEDIATE,
-	M_ZEROPAGE,
-	M_ZEROPAGE_X,
-	M_ZEROPAGE_Y,
-	M_RELATIVE,
-	M_ABSOLUTE,
-	M_ABSOLUTE_X,
-	M_ABSOLUTE_Y,
-	M_INDIRECT,
-	M_INDIRECT_X,
-	M_INDIRECT_Y,
-	M_IMPLIED,
-} AddressingMode;
-
-#define ARGP cpuRead(cpu, cpu->pc++)
+#ifdef NESINC_JIT
+#include "cpu_jit.h"
+#endif
 
 #define UPDATE(X) _updateZeroAndNeg(cpu, X)
-#define ADDR _getAddressFromMode(cpu, MODE)
-#define MEMADDR cpuRead(cpu, ADDR)
+#define ADDR _getAddressFromMode(cpu, MODE, ARG)
+#define MEMADDR _readOperand(cpu, MODE, ARG)
 
-static void _gameCallback(PPU *ppu, Joypad *joy1, Joypad *joy2) {
-	ppuRender(ppu);
+/* The CPU that's running, so its trace can be dumped if the emulator dies */
+static CPU *gRunning = NULL;
 
-	SDL_UpdateTexture(gScreen.texture, NULL, &ppu->frame.data, 256 * 3);
-	SDL_RenderCopy(gScreen.renderer, gScreen.texture, NULL, NULL);
-	SDL_RenderPresent(gScreen.renderer);
+/* By the time the frame is done, ppuTick has drawn every line of it */
+static void _gameCallback(PPU *ppu, Joypad *joy1, Joypad *joy2) {
+	screenPresent(&gScreen, &ppu->frame);
 
 	SDL_Event e;
 	while( SDL_PollEvent(&e) ) {
 		switch( e.type ) {
 			case SDL_QUIT:
+				gRunning = NULL;
 				exit(23);
 			case SDL_KEYDOWN:
 				switch( e.key.keysym.sym ) {
 					case SDLK_ESCAPE:
+						gRunning = NULL;
 						exit(24);
 					case SDLK_a:
 						joy1->data.btnA = 1;
@@ -116,19 +110,21 @@ static inline void _clearCarry(CPU *cpu) {
 }
 
 static inline void _setZero(CPU *cpu) {
-	cpu->status.zero = 1;
+	cpu->zeroResult = 0;
 }
 
 static inline void _clearZero(CPU *cpu) {
-	cpu->status.zero = 0;
+	cpu->zeroResult = 1;
 }
 
 static inline void _setIntr(CPU *cpu) {
 	cpu->status.interrupt = 1;
+	busMaskIRQ(&cpu->bus, true);
 }
 
 static inline void _clearIntr(CPU *cpu) {
-	cpu->status.interrupt = 1;
+	cpu->status.interrupt = 0;
+	busMaskIRQ(&cpu->bus, false);
 }
 
 static inline void _setDecimal(CPU *cpu) {
@@ -164,79 +160,155 @@ static inline void _clearOverflow(CPU *cpu) {
 }
 
 static inline void _setNegative(CPU *cpu) {
-	cpu->status.negative = 1;
+	cpu->negResult = SIGN_BIT;
 }
 
 static inline void _clearNegative(CPU *cpu) {
-	cpu->status.negative = 0;
+	cpu->negResult = 0;
+}
+
+static inline bool _isZero(CPU *cpu) {
+	return cpu->zeroResult == 0;
+}
+
+static inline bool _isNegative(CPU *cpu) {
+	return (cpu->negResult & SIGN_BIT) != 0;
+}
+
+uint8_t cpuGetStatus(CPU *cpu) {
+	const uint8_t ZN = (ALU_ZN[cpu->zeroResult] & ZERO_BIT) |
+					   (ALU_ZN[cpu->negResult] & SIGN_BIT);
+
+	cpu->status.bits &= (uint8_t)~(ZERO_BIT | SIGN_BIT);
+	cpu->status.bits |= ZN;
+
+	return cpu->status.bits;
+}
+
+void cpuSetStatus(CPU *cpu, const uint8_t BITS) {
+	cpu->status.bits = BITS;
+
+	cpu->zeroResult = cpu->status.zero ? 0 : 1;
+	cpu->negResult = BITS & SIGN_BIT;
+
+	busMaskIRQ(&cpu->bus, cpu->status.interrupt);
+}
+
+/* Internal RAM fast paths
+ *
+ * The zero page, the stack and zero page pointers can only ever be internal
+ * RAM, so they index it directly instead of going through the page table.
+ * Watches still get to see them through cpuRead and cpuWrite
+ */
+static ALWAYS_INLINE uint8_t _readRAM(CPU *cpu, const uint16_t ADDRESS) {
+	if( cpu->watches != NULL ) {
+		return cpuRead(cpu, ADDRESS);
+	}
+
+	return busReadRAM(&cpu->bus, ADDRESS);
+}
+
+static ALWAYS_INLINE void _writeRAM(CPU *cpu, const uint16_t ADDRESS,
+									const uint8_t VALUE) {
+	if( cpu->watches != NULL ) {
+		cpuWrite(cpu, ADDRESS, VALUE);
+		return;
+	}
+
+	busWriteRAM(&cpu->bus, ADDRESS, VALUE);
 }
 
-static uint16_t _getAddressFromMode(CPU *cpu, const AddressingMode MODE) {
+/* Reads a pointer from the zero page. The high byte of a pointer at $FF comes
+ * from $00
+ */
+static ALWAYS_INLINE uint16_t _readPointerZP(CPU *cpu, const uint8_t ADDRESS) {
+	const uint8_t LO = _readRAM(cpu, ADDRESS);
+	const uint8_t HI = _readRAM(cpu, (uint8_t)(ADDRESS + 1));
+
+	return (uint16_t)((HI << 8) | LO);
+}
+
+/* Vectors are in the last page of PRG ROM, which is always plain memory */
+static inline uint16_t _readVector(CPU *cpu, const uint16_t VECTOR) {
+	const uint8_t *PAGE = cpu->bus.pages[VECTOR >> 8].read;
+
+	if( PAGE == NULL || cpu->watches != NULL ) {
+		return cpuRead16(cpu, VECTOR);
+	}
+
+	const uint8_t OFFSET = (uint8_t)VECTOR;
+	return (uint16_t)(PAGE[OFFSET] | (PAGE[OFFSET + 1] << 8));
+}
+
+static ALWAYS_INLINE bool _isZeroPageMode(const AddressingMode MODE) {
+	return MODE == M_ZEROPAGE || MODE == M_ZEROPAGE_X || MODE == M_ZEROPAGE_Y;
+}
+
+/* Memory accesses from handlers. MODE is known once a handler is specialized,
+ * so zero page modes get the RAM fast path without a runtime check
+ */
+static ALWAYS_INLINE uint8_t _load(CPU *cpu, const AddressingMode MODE,
+								   const uint16_t ADDRESS) {
+	return _isZeroPageMode(MODE) ? _readRAM(cpu, ADDRESS)
+								 : cpuRead(cpu, ADDRESS);
+}
+
+static ALWAYS_INLINE void _store(CPU *cpu, const AddressingMode MODE,
+								 const uint16_t ADDRESS, const uint8_t VALUE) {
+	if( _isZeroPageMode(MODE) ) {
+		_writeRAM(cpu, ADDRESS, VALUE);
+	} else {
+		cpuWrite(cpu, ADDRESS, VALUE);
+	}
+}
+
+/* Resolves the effective address of an operand. ARG holds the operand bytes
+ * that follow the opcode, and the PC already points at the next instruction
+ *
+ * This is always inlined, so that handlers with a known mode don't pay for
+ * the switch
+ */
+static ALWAYS_INLINE uint16_t _getAddressFromMode(CPU *cpu,
+												  const AddressingMode MODE,
+												  const uint16_t ARG) {
 	switch( MODE ) {
 		case M_RELATIVE:
 		case M_IMMEDIATE:
-			return cpu->pc++;
+			return cpu->pc - 1;
 
 		case M_ZEROPAGE:
-			return ARGP;
+			return ARG;
 
 		case M_ZEROPAGE_X:
-			return (ARGP + cpu->regX) & 0xFF;
+			return (ARG + cpu->regX) & 0xFF;
 
 		case M_ZEROPAGE_Y:
-			return (ARGP + cpu->regY) & 0xFF;
+			return (ARG + cpu->regY) & 0xFF;
 
-		case M_ABSOLUTE: {
-			const uint16_t LO = ARGP;
-			const uint16_t HI = ARGP;
+		case M_ABSOLUTE:
+			return ARG;
 
-			return ((HI << 8) | LO);
-		}
-
-		case M_ABSOLUTE_X: {
-			const uint16_t LO = ARGP;
-			const uint16_t HI = ARGP;
-
-			const uint16_t ADDRESS = (uint16_t)((HI << 8) | LO);
-			return (uint16_t)(ADDRESS + cpu->regX);
-		}
-
-		case M_ABSOLUTE_Y: {
-			const uint16_t LO = ARGP;
-			const uint16_t HI = ARGP;
+		case M_ABSOLUTE_X:
+			return (uint16_t)(ARG + cpu->regX);
 
-			const uint16_t ADDRESS = (uint16_t)((HI << 8) | LO);
-			return (uint16_t)(ADDRESS + cpu->regY);
-		}
+		case M_ABSOLUTE_Y:
+			return (uint16_t)(ARG + cpu->regY);
 
 		case M_INDIRECT: {
-			uint8_t loByte = ARGP;
-			const uint8_t HI = ARGP;
+			uint8_t loByte = (uint8_t)(ARG & 0xFF);
+			const uint16_t HI = ARG & 0xFF00;
 
-			const uint8_t LO_PTR = cpuRead(cpu, (HI << 8) | (loByte++));
-			const uint8_t HI_PTR = cpuRead(cpu, (HI << 8) | loByte);
+			const uint8_t LO_PTR = cpuRead(cpu, HI | (loByte++));
+			const uint8_t HI_PTR = cpuRead(cpu, HI | loByte);
 
 			return (HI_PTR << 8) | LO_PTR;
 		}
 
-		case M_INDIRECT_X: {
-			uint8_t zpAddress = ARGP + cpu->regX;
+		case M_INDIRECT_X:
+			return _readPointerZP(cpu, (uint8_t)(ARG + cpu->regX));
 
-			const uint8_t LO = cpuRead(cpu, zpAddress++);
-			const uint8_t HI = cpuRead(cpu, zpAddress);
-
-			return (HI << 8) | LO;
-		}
-
-		case M_INDIRECT_Y: {
-			uint8_t ptr = ARGP;
-
-			const uint16_t LO = cpuRead(cpu, ptr++);
-			const uint16_t HI = cpuRead(cpu, ptr);
-
-			const uint16_t DEREF = (HI << 8) | LO;
-			return DEREF + cpu->regY;
-		}
+		case M_INDIRECT_Y:
+			return (uint16_t)(_readPointerZP(cpu, (uint8_t)ARG) + cpu->regY);
 
 		case M_IMPLIED:
 			return 0;
@@ -247,82 +319,129 @@ static uint16_t _getAddressFromMode(CPU *cpu, const AddressingMode MODE) {
 	}
 }
 
-static void _updateZeroAndNeg(CPU *cpu, const uint8_t RESULT) {
-	if( RESULT == 0 ) {
-		_setZero(cpu);
-	} else {
-		_clearZero(cpu);
-	}
+/* Indexing across a page boundary costs an extra cycle, to fix up the high
+ * byte. The comparison compiles to a setcc, so there's no branch to mispredict
+ */
+static ALWAYS_INLINE void _chargePageCross(CPU *cpu, const uint16_t BASE,
+										   const uint16_t ADDRESS) {
+	cpu->bus.cycles += (size_t)((BASE ^ ADDRESS) > 0xFF);
+}
 
-	if( (RESULT & SIGN_BIT) != 0 ) {
-		_setNegative(cpu);
-	} else {
-		_clearNegative(cpu);
+/* Reads the value of an operand. Immediate operands are already in ARG, so
+ * there's no need to go through the bus for them
+ *
+ * Only reads pay the page crossing penalty. Stores and read-modify-writes
+ * always take the long way, and the table already charges them for it
+ */
+static ALWAYS_INLINE uint8_t _readOperand(CPU *cpu, const AddressingMode MODE,
+										  const uint16_t ARG) {
+	switch( MODE ) {
+		case M_IMMEDIATE:
+			return (uint8_t)ARG;
+
+		case M_ABSOLUTE_X:
+		case M_ABSOLUTE_Y:
+		case M_INDIRECT_Y: {
+			const uint16_t BASE = (MODE == M_INDIRECT_Y)
+									  ? _readPointerZP(cpu, (uint8_t)ARG)
+									  : ARG;
+			const uint8_t INDEX = (MODE == M_ABSOLUTE_X) ? cpu->regX : cpu->regY;
+			const uint16_t ADDRESS = (uint16_t)(BASE + INDEX);
+
+			_chargePageCross(cpu, BASE, ADDRESS);
+			return cpuRead(cpu, ADDRESS);
+		}
+
+		default:
+			return _load(cpu, MODE, _getAddressFromMode(cpu, MODE, ARG));
 	}
 }
 
-static void _addToA(CPU *cpu, const uint8_t VALUE) {
-	uint16_t sum = (uint16_t)(cpu->regA + VALUE);
-	sum += ((cpu->status.carry) ? 1 : 0);
+/* Fetches the operand bytes of the current instruction and moves the PC to
+ * the next one
+ */
+static ALWAYS_INLINE uint16_t _fetchOperand(CPU *cpu, const uint8_t BYTES) {
+	uint16_t operand = 0;
 
-	if( sum > UINT8_MAX ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
+	switch( BYTES ) {
+		case 2:
+			operand = busRead(&cpu->bus, cpu->pc);
+			break;
+
+		case 3:
+			operand = busRead16(&cpu->bus, cpu->pc);
+			break;
 	}
 
-	const uint8_t RESULT = (uint8_t)sum;
+	cpu->pc += (uint16_t)(BYTES - 1);
+	return operand;
+}
 
-	if( ((VALUE ^ RESULT) & (RESULT ^ cpu->regA) & 0x80) != 0 ) {
-		_setOverflow(cpu);
-	} else {
-		_clearOverflow(cpu);
-	}
+/* Zero and negative are only worked out from RESULT once something reads
+ * them, see cpuGetStatus
+ */
+static inline void _updateZeroAndNeg(CPU *cpu, const uint8_t RESULT) {
+	cpu->zeroResult = RESULT;
+	cpu->negResult = RESULT;
+}
+
+/* Keeps the carry out of a widened ALU result, see cpu_alu.h */
+static ALWAYS_INLINE uint8_t _withCarry(CPU *cpu, const uint16_t RESULT) {
+	cpu->status.carry = aluCarry(RESULT);
+	return (uint8_t)RESULT;
+}
+
+/* Adds a byte and the carry to the accumulator. SBC adds the inverted byte */
+static void _addToA(CPU *cpu, const uint8_t VALUE) {
+	const uint8_t RESULT =
+		_withCarry(cpu, aluAdd(cpu->regA, VALUE, cpu->status.carry));
+
+	cpu->status.overflow = aluOverflow(cpu->regA, VALUE, RESULT);
 
 	cpu->regA = RESULT;
 	UPDATE(cpu->regA);
 }
 
-static void _lsrA(CPU *cpu) {
-	if( (cpu->regA & 1) == 1 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
+/* Compares are a subtraction that only keeps the flags */
+static void _compare(CPU *cpu, const uint8_t REG, const uint8_t VALUE) {
+	UPDATE(_withCarry(cpu, aluSub(REG, VALUE, 1)));
+}
 
-	cpu->regA >>= 1;
+static void _lsrA(CPU *cpu) {
+	cpu->regA = _withCarry(cpu, aluLsr(cpu->regA));
 	UPDATE(cpu->regA);
 }
 
 static void _rorA(CPU *cpu) {
-	const bool OLD_CARRY = (cpu->status.carry == 1);
-
-	if( (cpu->regA & 1) == 1 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
-
-	cpu->regA >>= 1;
-
-	if( OLD_CARRY ) {
-		cpu->regA |= SIGN_BIT;
-	}
-
+	cpu->regA = _withCarry(cpu, aluRor(cpu->regA, cpu->status.carry));
 	UPDATE(cpu->regA);
 }
 
-static void _branch(CPU *cpu, const uint8_t COMPARISON) {
+/* Checks whether a taken branch just closed an idle loop, see cpuIsIdleLoop */
+static NOINLINE void _branchBack(CPU *cpu);
+
+static ALWAYS_INLINE void _branch(CPU *cpu, const uint8_t COMPARISON,
+								  const uint16_t ARG) {
 	if( COMPARISON ) {
-		cpu->pc = (uint16_t)(cpu->pc + ((int8_t)cpuRead(cpu, cpu->pc)) + 1);
-		return;
+		const uint16_t TARGET = (uint16_t)(cpu->pc + (int8_t)ARG);
+
+		/* Taking the branch costs a cycle, and landing on another page one
+		 * more
+		 */
+		cpu->bus.cycles += 1 + (size_t)((cpu->pc ^ TARGET) > 0xFF);
+		cpu->pc = TARGET;
+
+		/* Idle loops are 4 or 5 bytes long, so only those branches can close
+		 * one
+		 */
+		if( (uint8_t)(ARG + 5) <= 1 ) {
+			_branchBack(cpu);
+		}
 	}
-
-	cpu->pc++;
 }
 
 static void _push(CPU *cpu, const uint8_t VALUE) {
-	cpuWrite(cpu, 0x0100 + cpu->stack, VALUE);
+	_writeRAM(cpu, 0x0100 + cpu->stack, VALUE);
 	--cpu->stack;
 }
 
@@ -336,7 +455,7 @@ static void _push16(CPU *cpu, const uint16_t VALUE) {
 
 static uint8_t _pull(CPU *cpu) {
 	++cpu->stack;
-	return cpuRead(cpu, 0x0100 + cpu->stack);
+	return _readRAM(cpu, 0x0100 + cpu->stack);
 }
 
 static uint16_t _pull16(CPU *cpu) {
@@ -346,20 +465,25 @@ static uint16_t _pull16(CPU *cpu) {
 	return (HI << 8) | LO;
 }
 
-#define OP_FN(N) static void N(CPU *cpu, const AddressingMode MODE)
-typedef void (*OpFn)(CPU *cpu, const AddressingMode);
+#define OP_FN(N)                                                     \
+	static ALWAYS_INLINE void N(CPU *cpu, const AddressingMode MODE, \
+								const uint16_t ARG)
+typedef void (*OpFn)(CPU *cpu);
+typedef void (*OpExecFn)(CPU *cpu, const uint16_t ARG);
 
 typedef struct _Op {
-	OpFn fn;
+	OpFn fn;	   /* Fetches the operand, then executes */
+	OpExecFn exec; /* Executes with an already fetched operand */
 	AddressingMode mode;
 	uint8_t cycles;
 	uint8_t bytes;
 	const char NAME[5];
 } Op;
 
-#define NOP      \
-	UNUSED(cpu); \
-	UNUSED(MODE);
+#define NOP       \
+	UNUSED(cpu);  \
+	UNUSED(MODE); \
+	UNUSED(ARG);
 
 /* Adds a byte to the accumulator, with carry */
 OP_FN(_adc) {
@@ -371,16 +495,14 @@ OP_FN(_adc) {
  */
 OP_FN(_ahx) {
 	const uint8_t RESULT = (cpu->regA & cpu->regX) & 7;
-	cpuWrite(cpu, ADDR, RESULT);
+	_store(cpu, MODE, ADDR, RESULT);
 }
 
 /* ANDs a byte with accumulator, then preforms a logical shift right on the
  * accumulator
  */
 OP_FN(_alr) {
-	UNUSED(MODE);
-
-	cpu->regA &= cpuRead(cpu, ++cpu->pc);
+	cpu->regA &= MEMADDR;
 	_lsrA(cpu);
 }
 
@@ -391,11 +513,7 @@ OP_FN(_anc) {
 	cpu->regA &= MEMADDR;
 	UPDATE(cpu->regA);
 
-	if( cpu->status.negative != 0 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
+	cpu->status.carry = (cpu->regA & SIGN_BIT) != 0;
 }
 
 /* ANDs byte with the accumulator */
@@ -423,47 +541,26 @@ OP_FN(_and) {
 OP_FN(_arr) {
 	cpu->regA &= MEMADDR;
 	_rorA(cpu);
-	UPDATE(cpu->regA);
 
-	const uint8_t BIT_5 = (cpu->regA >> 5) & 1;
-	const uint8_t BIT_6 = (cpu->regA >> 6) & 1;
-
-	if( BIT_6 == 1 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
+	const bool BIT_5 = (cpu->regA & 0x20) != 0;
+	const bool BIT_6 = (cpu->regA & 0x40) != 0;
 
-	if( (BIT_5 ^ BIT_6) == 1 ) {
-		_setOverflow(cpu);
-	} else {
-		_clearOverflow(cpu);
-	}
+	cpu->status.carry = BIT_6;
+	cpu->status.overflow = BIT_5 != BIT_6;
 }
 
 /* Performs an arithmetic shift left on a byte */
 OP_FN(_asl) {
 	if( MODE == M_IMPLIED ) {
-		if( cpu->regA > 127 ) {
-			_setCarry(cpu);
-		} else {
-			_clearCarry(cpu);
-		}
-
-		cpu->regA = (uint8_t)(cpu->regA << 1);
+		cpu->regA = _withCarry(cpu, aluAsl(cpu->regA));
 		UPDATE(cpu->regA);
 	} else {
 		const uint16_t ADDRESS = ADDR;
-		const uint8_t VALUE = cpuRead(cpu, ADDRESS);
+		const uint8_t RESULT =
+			_withCarry(cpu, aluAsl(_load(cpu, MODE, ADDRESS)));
 
-		if( VALUE > 127 ) {
-			_setCarry(cpu);
-		} else {
-			_clearCarry(cpu);
-		}
-
-		cpuWrite(cpu, ADDRESS, VALUE << 1);
-		UPDATE(VALUE);
+		_store(cpu, MODE, ADDRESS, RESULT);
+		UPDATE(RESULT);
 	}
 }
 
@@ -483,31 +580,26 @@ OP_FN(_atx) {
 OP_FN(_axs) {
 	const uint8_t VALUE = MEMADDR;
 
-	cpu->regX &= cpu->regA;
-	if( VALUE <= cpu->regX ) {
-		_setCarry(cpu);
-	}
-
-	cpu->regX -= VALUE;
+	cpu->regX = _withCarry(cpu, aluSub(cpu->regA & cpu->regX, VALUE, 1));
 	UPDATE(cpu->regX);
 }
 
 /* Branches if the carry flag is clear */
 OP_FN(_bcc) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.carry == 0);
+	_branch(cpu, cpu->status.carry == 0, ARG);
 }
 
 /* Branches if the carry flag is set */
 OP_FN(_bcs) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.carry == 1);
+	_branch(cpu, cpu->status.carry == 1, ARG);
 }
 
 /* Branches if the zero flag is set */
 OP_FN(_beq) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.zero == 1);
+	_branch(cpu, _isZero(cpu), ARG);
 }
 
 /* Tests if the bits of a memory location are set by ANDing them with a mask
@@ -520,76 +612,66 @@ OP_FN(_beq) {
 OP_FN(_bit) {
 	const uint8_t VALUE = MEMADDR;
 
-	if( (cpu->regA & VALUE) == 0 ) {
-		_setZero(cpu);
-	} else {
-		_clearZero(cpu);
-	}
-
-	if( (VALUE & SIGN_BIT) != 0 ) {
-		_setNegative(cpu);
-	} else {
-		_clearNegative(cpu);
-	}
-
-	if( (VALUE & OVERFLOW_BIT) != 0 ) {
-		_setOverflow(cpu);
-	} else {
-		_clearOverflow(cpu);
-	}
+	cpu->zeroResult = cpu->regA & VALUE;
+	cpu->negResult = VALUE;
+	cpu->status.overflow = (VALUE & OVERFLOW_BIT) != 0;
 }
 
 /* Branches if the negative flag is set */
 OP_FN(_bmi) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.negative == 1);
+	_branch(cpu, _isNegative(cpu), ARG);
 }
 
 /* Branches if the zero flag is clear */
 OP_FN(_bne) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.zero == 0);
+	_branch(cpu, !_isZero(cpu), ARG);
 }
 
 /* Branches if the negative flag is clear */
 OP_FN(_bpl) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.negative == 0);
+	_branch(cpu, !_isNegative(cpu), ARG);
 }
 
 /* Branches if the overflow flag is clear */
 OP_FN(_bvc) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.overflow == 0);
+	_branch(cpu, cpu->status.overflow == 0, ARG);
 }
 
 /* Branches if the overflow flag is set */
 OP_FN(_bvs) {
 	UNUSED(MODE);
-	_branch(cpu, cpu->status.overflow == 1);
+	_branch(cpu, cpu->status.overflow == 1, ARG);
 }
 
 /* Clears the carry flag */
 OP_FN(_clc) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_clearCarry(cpu);
 }
 
 /* Clears the decimal flag */
 OP_FN(_cld) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_clearDecimal(cpu);
 }
 
 /* Clears the interrupt flag */
 OP_FN(_cli) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_clearIntr(cpu);
 }
 
 /* Clears the overflow flag */
 OP_FN(_clv) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_clearOverflow(cpu);
 }
 
@@ -601,55 +683,26 @@ OP_FN(_clv) {
  * - Negative flag: set if A - M is negative
  */
 OP_FN(_cmp) {
-	const uint8_t VALUE = MEMADDR;
-
-	if( VALUE <= cpu->regA ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
-
-	UPDATE(cpu->regA - VALUE);
+	_compare(cpu, cpu->regA, MEMADDR);
 }
 
 /* Same as CMP, but compares with the X register instead of the accumulator */
 OP_FN(_cpx) {
-	const uint8_t VALUE = MEMADDR;
-
-	if( VALUE <= cpu->regX ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
-
-	UPDATE(cpu->regX - VALUE);
+	_compare(cpu, cpu->regX, MEMADDR);
 }
 
 /* Same as CMP, but compares with the Y register instead of the accumulator */
 OP_FN(_cpy) {
-	const uint8_t VALUE = MEMADDR;
-
-	if( VALUE <= cpu->regY ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
-
-	UPDATE(cpu->regY - VALUE);
+	_compare(cpu, cpu->regY, MEMADDR);
 }
 
 /* Subtracts 1 from a value in memory, without borrow */
 OP_FN(_dcp) {
 	const uint16_t ADDRESS = ADDR;
+	const uint8_t VALUE = (uint8_t)(_load(cpu, MODE, ADDRESS) - 1);
 
-	const uint8_t VALUE = cpuRead(cpu, ADDRESS) - 1;
-	cpuWrite(cpu, ADDRESS, VALUE);
-
-	if( VALUE <= cpu->regA ) {
-		_setCarry(cpu);
-	}
-
-	UPDATE(cpu->regA - VALUE);
+	_store(cpu, MODE, ADDRESS, VALUE);
+	_compare(cpu, cpu->regA, VALUE);
 }
 
 /* Decreases a values in memory by 1 */
@@ -657,15 +710,16 @@ OP_FN(_dec) {
 	UNUSED(MODE);
 
 	const uint16_t ADDRESS = ADDR;
-	const uint8_t VALUE = cpuRead(cpu, ADDRESS) - 1;
+	const uint8_t VALUE = _load(cpu, MODE, ADDRESS) - 1;
 
-	cpuWrite(cpu, ADDRESS, VALUE);
+	_store(cpu, MODE, ADDRESS, VALUE);
 	UPDATE(VALUE);
 }
 
 /* Decreases the value in the X register by 1 */
 OP_FN(_dex) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	--cpu->regX;
 	UPDATE(cpu->regX);
@@ -674,6 +728,7 @@ OP_FN(_dex) {
 /* Decreases the value in the Y register by 1 */
 OP_FN(_dey) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	--cpu->regY;
 	UPDATE(cpu->regY);
@@ -688,15 +743,16 @@ OP_FN(_eor) {
 /* Increases a value in memory by 1 */
 OP_FN(_inc) {
 	const uint16_t ADDRESS = ADDR;
-	const uint8_t VALUE = cpuRead(cpu, ADDRESS) + 1;
+	const uint8_t VALUE = _load(cpu, MODE, ADDRESS) + 1;
 
-	cpuWrite(cpu, ADDRESS, VALUE);
+	_store(cpu, MODE, ADDRESS, VALUE);
 	UPDATE(VALUE);
 }
 
 /* Increases the value in the X register by 1 */
 OP_FN(_inx) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	++cpu->regX;
 	UPDATE(cpu->regX);
@@ -705,6 +761,7 @@ OP_FN(_inx) {
 /* Increases the value in the Y register by 1 */
 OP_FN(_iny) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	++cpu->regY;
 	UPDATE(cpu->regY);
@@ -715,12 +772,10 @@ OP_FN(_iny) {
  */
 OP_FN(_isb) {
 	const uint16_t ADDRESS = ADDR;
-	const uint8_t VALUE = cpuRead(cpu, ADDRESS) + 1;
-
-	cpuWrite(cpu, ADDRESS, VALUE);
-	UPDATE(VALUE);
+	const uint8_t VALUE = (uint8_t)(_load(cpu, MODE, ADDRESS) + 1);
 
-	_addToA(cpu, 255 - cpuRead(cpu, ADDRESS));
+	_store(cpu, MODE, ADDRESS, VALUE);
+	_addToA(cpu, (uint8_t)~VALUE);
 }
 
 /* Jumps (sets the PC to) an address */
@@ -734,7 +789,7 @@ OP_FN(_jmp) {
  */
 OP_FN(_jsr) {
 	UNUSED(MODE);
-	_push16(cpu, cpu->pc + 1);
+	_push16(cpu, cpu->pc - 1);
 
 	cpu->pc = ADDR;
 }
@@ -783,22 +838,21 @@ OP_FN(_lsr) {
 		_lsrA(cpu);
 	} else {
 		const uint16_t ADDRESS = ADDR;
-		const uint8_t VALUE = cpuRead(cpu, ADDRESS);
+		const uint8_t RESULT =
+			_withCarry(cpu, aluLsr(_load(cpu, MODE, ADDRESS)));
 
-		if( (VALUE & 1) == 1 ) {
-			_setCarry(cpu);
-		} else {
-			_clearCarry(cpu);
-		}
-
-		cpuWrite(cpu, ADDRESS, VALUE >> 1);
-		UPDATE(VALUE);
+		_store(cpu, MODE, ADDRESS, RESULT);
+		UPDATE(RESULT);
 	}
 }
 
-/* No operation */
+/* No operation. The indexed forms still pay for crossing a page */
 OP_FN(_nop) {
-	(void)ADDR;
+	if( MODE == M_ABSOLUTE_X ) {
+		_chargePageCross(cpu, ARG, (uint16_t)(ARG + cpu->regX));
+	}
+
+	NOP;
 }
 
 /* ORs a byte with the accumulator */
@@ -810,6 +864,7 @@ OP_FN(_ora) {
 /* Pushes a copy of the accumulator to the stack */
 OP_FN(_pha) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_push(cpu, cpu->regA);
 }
 
@@ -818,12 +873,14 @@ OP_FN(_pha) {
  */
 OP_FN(_php) {
 	UNUSED(MODE);
-	_push(cpu, cpu->status.bits | BFLAG1_BIT | BFLAG2_BIT);
+	UNUSED(ARG);
+	_push(cpu, cpuGetStatus(cpu) | BFLAG1_BIT | BFLAG2_BIT);
 }
 
 /* Pulls a value from the stack and sets the accumulator to that value */
 OP_FN(_pla) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->regA = _pull(cpu);
 	UPDATE(cpu->regA);
@@ -836,8 +893,9 @@ OP_FN(_pla) {
  */
 OP_FN(_plp) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
-	cpu->status.bits = _pull(cpu);
+	cpuSetStatus(cpu, _pull(cpu));
 	cpu->status.bFlag2 = 1;
 
 	_clearBFlag1(cpu);
@@ -848,23 +906,12 @@ OP_FN(_plp) {
  */
 OP_FN(_rla) {
 	const uint16_t ADDRESS = ADDR;
-	const uint8_t VALUE = cpuRead(cpu, ADDRESS);
-	const bool OLD_CARRY = (cpu->status.carry == 1);
+	const uint8_t RESULT = _withCarry(
+		cpu, aluRol(_load(cpu, MODE, ADDRESS), cpu->status.carry));
 
-	if( (VALUE >> 7) == 1 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
+	_store(cpu, MODE, ADDRESS, RESULT);
 
-	uint8_t val = VALUE << 1;
-	if( OLD_CARRY ) {
-		val |= 1;
-	}
-
-	cpuWrite(cpu, ADDRESS, val);
-
-	cpu->regA &= val;
+	cpu->regA &= RESULT;
 	UPDATE(cpu->regA);
 }
 
@@ -873,22 +920,11 @@ OP_FN(_rla) {
  */
 OP_FN(_rra) {
 	const uint16_t ADDRESS = ADDR;
-	const uint8_t VALUE = cpuRead(cpu, ADDRESS);
-	const bool OLD_CARRY = (cpu->status.carry == 1);
+	const uint8_t RESULT = _withCarry(
+		cpu, aluRor(_load(cpu, MODE, ADDRESS), cpu->status.carry));
 
-	if( (VALUE & 1) == 1 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
-
-	uint8_t val = (VALUE >> 1);
-	if( OLD_CARRY ) {
-		val |= SIGN_BIT;
-	}
-
-	cpuWrite(cpu, ADDRESS, val);
-	_addToA(cpu, val);
+	_store(cpu, MODE, ADDRESS, RESULT);
+	_addToA(cpu, RESULT);
 }
 
 /* Rotates a byte's bits left. This is the same as a LSR, but the 7th bit, that
@@ -903,38 +939,15 @@ OP_FN(_rra) {
  */
 OP_FN(_rol) {
 	if( MODE == M_IMPLIED ) {
-		const bool OLD_CARRY = (cpu->status.carry == 1);
-
-		if( (cpu->regA >> 7) == 1 ) {
-			_setCarry(cpu);
-		} else {
-			_clearCarry(cpu);
-		}
-
-		cpu->regA = (uint8_t)(cpu->regA << 1);
-		if( OLD_CARRY ) {
-			cpu->regA |= 1;
-		}
-
+		cpu->regA = _withCarry(cpu, aluRol(cpu->regA, cpu->status.carry));
 		UPDATE(cpu->regA);
 	} else {
 		const uint16_t ADDRESS = ADDR;
-		const uint8_t VALUE = cpuRead(cpu, ADDRESS);
-		const bool OLD_CARRY = (cpu->status.carry == 1);
-
-		if( (VALUE >> 7) == 1 ) {
-			_setCarry(cpu);
-		} else {
-			_clearCarry(cpu);
-		}
-
-		uint8_t val = VALUE << 1;
-		if( OLD_CARRY ) {
-			val |= 1;
-		}
+		const uint8_t RESULT = _withCarry(
+			cpu, aluRol(_load(cpu, MODE, ADDRESS), cpu->status.carry));
 
-		cpuWrite(cpu, ADDRESS, val);
-		UPDATE(val);
+		_store(cpu, MODE, ADDRESS, RESULT);
+		UPDATE(RESULT);
 	}
 }
 
@@ -944,22 +957,11 @@ OP_FN(_ror) {
 		_rorA(cpu);
 	} else {
 		const uint16_t ADDRESS = ADDR;
-		const uint8_t VALUE = cpuRead(cpu, ADDRESS);
-		const bool OLD_CARRY = (cpu->status.carry == 1);
+		const uint8_t RESULT = _withCarry(
+			cpu, aluRor(_load(cpu, MODE, ADDRESS), cpu->status.carry));
 
-		if( (VALUE & 1) == 1 ) {
-			_setCarry(cpu);
-		} else {
-			_clearCarry(cpu);
-		}
-
-		uint8_t val = (VALUE >> 1);
-		if( OLD_CARRY ) {
-			val |= SIGN_BIT;
-		}
-
-		cpuWrite(cpu, ADDRESS, val);
-		UPDATE(val);
+		_store(cpu, MODE, ADDRESS, RESULT);
+		UPDATE(RESULT);
 	}
 }
 
@@ -970,8 +972,9 @@ OP_FN(_ror) {
  */
 OP_FN(_rti) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
-	cpu->status.bits = _pull(cpu);
+	cpuSetStatus(cpu, _pull(cpu));
 	cpu->status.bFlag2 = 1;
 
 	_clearBFlag1(cpu);
@@ -981,35 +984,39 @@ OP_FN(_rti) {
 /* Returns from a subroutine by pulling the PC from the stack */
 OP_FN(_rts) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->pc = _pull16(cpu) + 1;
 }
 
 /* ANDs the A and X registers together and stores the result in memory */
 OP_FN(_sax) {
-	cpuWrite(cpu, ADDR, cpu->regA & cpu->regX);
+	_store(cpu, MODE, ADDR, cpu->regA & cpu->regX);
 }
 
 /* Subtracts a byte from the accumulator, with carry */
 OP_FN(_sbc) {
-	_addToA(cpu, 255 - cpuRead(cpu, ADDR));
+	_addToA(cpu, (uint8_t)~MEMADDR);
 }
 
 /* Sets the carry flag */
 OP_FN(_sec) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_setCarry(cpu);
 }
 
 /* Sets the decimal flag */
 OP_FN(_sed) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_setDecimal(cpu);
 }
 
 /* Sets the interrupt flag */
 OP_FN(_sei) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	_setIntr(cpu);
 }
 
@@ -1020,7 +1027,7 @@ OP_FN(_shx) {
 	const uint16_t ADDRESS = ADDR;
 	const uint8_t HI_BYTE = (uint8_t)((ADDRESS >> 8) + 1);
 
-	cpuWrite(cpu, ADDRESS, cpu->regX & HI_BYTE);
+	_store(cpu, MODE, ADDRESS, cpu->regX & HI_BYTE);
 }
 
 /* ANDs the Y register with the high byte of the given address, + 1
@@ -1030,58 +1037,44 @@ OP_FN(_shy) {
 	const uint16_t ADDRESS = ADDR;
 	const uint8_t HI_BYTE = (uint8_t)((ADDRESS >> 8) + 1);
 
-	cpuWrite(cpu, ADDRESS, cpu->regY & HI_BYTE);
+	_store(cpu, MODE, ADDRESS, cpu->regY & HI_BYTE);
 }
 
 /* ASLs a value in memory and ORs the accumulator with the result */
 OP_FN(_slo) {
 	const uint16_t ADDRESS = ADDR;
-	uint8_t value = cpuRead(cpu, ADDRESS);
+	const uint8_t RESULT = _withCarry(cpu, aluAsl(_load(cpu, MODE, ADDRESS)));
 
-	if( value > 127 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
+	_store(cpu, MODE, ADDRESS, RESULT);
 
-	value = (uint8_t)(value << 1);
-
-	cpuWrite(cpu, ADDRESS, value);
-
-	cpu->regA |= value;
+	cpu->regA |= RESULT;
 	UPDATE(cpu->regA);
 }
 
 /* LSRs a value in memory and XORs the accumulator with the result */
 OP_FN(_sre) {
 	const uint16_t ADDRESS = ADDR;
-	uint8_t value = cpuRead(cpu, ADDRESS);
+	const uint8_t RESULT = _withCarry(cpu, aluLsr(_load(cpu, MODE, ADDRESS)));
 
-	if( (value & 1) == 1 ) {
-		_setCarry(cpu);
-	} else {
-		_clearCarry(cpu);
-	}
+	_store(cpu, MODE, ADDRESS, RESULT);
 
-	value >>= 1;
-
-	cpuWrite(cpu, ADDRESS, value);
-	cpu->regA ^= value;
+	cpu->regA ^= RESULT;
+	UPDATE(cpu->regA);
 }
 
 /* Stores the accumulator contents in memory */
 OP_FN(_sta) {
-	cpuWrite(cpu, ADDR, cpu->regA);
+	_store(cpu, MODE, ADDR, cpu->regA);
 }
 
 /* Stores the X register contents in memory */
 OP_FN(_stx) {
-	cpuWrite(cpu, ADDR, cpu->regX);
+	_store(cpu, MODE, ADDR, cpu->regX);
 }
 
 /* Stores the Y register contents in memory */
 OP_FN(_sty) {
-	cpuWrite(cpu, ADDR, cpu->regY);
+	_store(cpu, MODE, ADDR, cpu->regY);
 }
 
 /* ANDs the accumulator with the X register and stores the result on the stack
@@ -1096,14 +1089,15 @@ OP_FN(_tas) {
 	cpu->stack = cpu->regA & cpu->regX;
 
 	const uint16_t ADDRESS = ADDR;
-	const uint8_t HI_BYTE = (uint8_t)((ADDR >> 8) + 1);
+	const uint8_t HI_BYTE = (uint8_t)((ADDRESS >> 8) + 1);
 
-	cpuWrite(cpu, ADDRESS, cpu->stack & HI_BYTE);
+	_store(cpu, MODE, ADDRESS, cpu->stack & HI_BYTE);
 }
 
 /* Transfer the contents of the accumulator to the X register */
 OP_FN(_tax) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->regX = cpu->regA;
 	UPDATE(cpu->regX);
@@ -1112,6 +1106,7 @@ OP_FN(_tax) {
 /* Transfer the contents of the accumulator to the Y register */
 OP_FN(_tay) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->regY = cpu->regA;
 	UPDATE(cpu->regY);
@@ -1120,6 +1115,7 @@ OP_FN(_tay) {
 /* Transfer the stack pointer to the X register */
 OP_FN(_tsx) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->regX = cpu->stack;
 	UPDATE(cpu->regX);
@@ -1128,6 +1124,7 @@ OP_FN(_tsx) {
 /* Transfer the contents of the X register to the accumulator */
 OP_FN(_txa) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->regA = cpu->regX;
 	UPDATE(cpu->regA);
@@ -1136,12 +1133,14 @@ OP_FN(_txa) {
 /* Transfer the contents of the X register to the stack pointer */
 OP_FN(_txs) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 	cpu->stack = cpu->regX;
 }
 
 /* Transfer the contents of the Y register to the accumulator */
 OP_FN(_tya) {
 	UNUSED(MODE);
+	UNUSED(ARG);
 
 	cpu->regA = cpu->regY;
 	UPDATE(cpu->regA);
@@ -1169,346 +1168,328 @@ OP_FN(_xaa) {
 	UPDATE(cpu->regA);
 }
 
-static const Op OPS[256] = {
-	[0x69] = {_adc, M_IMMEDIATE, 2, 2, "ADC"},
-	[0x65] = {_adc, M_ZEROPAGE, 3, 2, "ADC"},
-	[0x75] = {_adc, M_ZEROPAGE_X, 4, 2, "ADC"},
-	[0x6D] = {_adc, M_ABSOLUTE, 4, 3, "ADC"},
-	[0x7D] = {_adc, M_ABSOLUTE_X, 4, 3, "ADC"},
-	[0x79] = {_adc, M_ABSOLUTE_Y, 4, 3, "ADC"},
-	[0x61] = {_adc, M_INDIRECT_X, 6, 2, "ADC"},
-	[0x71] = {_adc, M_INDIRECT_Y, 5, 2, "ADC"},
-
-	[0x9F] = {_ahx, M_ABSOLUTE_Y, 5, 3, "*AHX"},
-	[0x93] = {_ahx, M_INDIRECT_Y, 6, 3, "*AHX"},
-
-	[0x4B] = {_alr, M_IMMEDIATE, 2, 2, "*ALR"},
-
-	[0x0B] = {_anc, M_IMMEDIATE, 2, 2, "*ANC"},
-	[0x2B] = {_anc, M_IMMEDIATE, 2, 2, "*ANC"},
-
-	[0x29] = {_and, M_IMMEDIATE, 2, 2, "AND"},
-	[0x25] = {_and, M_ZEROPAGE, 3, 2, "AND"},
-	[0x35] = {_and, M_ZEROPAGE_X, 4, 2, "AND"},
-	[0x2D] = {_and, M_ABSOLUTE, 4, 3, "AND"},
-	[0x3D] = {_and, M_ABSOLUTE_X, 4, 3, "AND"},
-	[0x39] = {_and, M_ABSOLUTE_Y, 4, 3, "AND"},
-	[0x21] = {_and, M_INDIRECT_X, 6, 2, "AND"},
-	[0x31] = {_and, M_INDIRECT_Y, 5, 2, "AND"},
-
-	[0x6B] = {_arr, M_IMMEDIATE, 2, 2, "*ARR"},
-
-	[0x0A] = {_asl, M_IMPLIED, 2, 1, "ASL"},
-	[0x06] = {_asl, M_ZEROPAGE, 5, 2, "ASL"},
-	[0x16] = {_asl, M_ZEROPAGE_X, 6, 2, "ASL"},
-	[0x0E] = {_asl, M_ABSOLUTE, 6, 3, "ASL"},
-	[0x1E] = {_asl, M_ABSOLUTE_X, 7, 3, "ASL"},
-
-	[0XAB] = {_atx, M_IMMEDIATE, 2, 2, "*ATX"},
-
-	[0XCB] = {_axs, M_IMMEDIATE, 2, 2, "*AXS"},
-
-	[0x90] = {_bcc, M_RELATIVE, 2, 2, "BCC"},
-	[0xB0] = {_bcs, M_RELATIVE, 2, 2, "BCS"},
-	[0xF0] = {_beq, M_RELATIVE, 2, 2, "BEQ"},
-	[0xD0] = {_bne, M_RELATIVE, 2, 2, "BNE"},
-
-	[0x24] = {_bit, M_ZEROPAGE, 3, 2, "BIT"},
-	[0x2C] = {_bit, M_ABSOLUTE, 4, 3, "BIT"},
-
-	[0x30] = {_bmi, M_RELATIVE, 2, 2, "BMI"},
-	[0x10] = {_bpl, M_RELATIVE, 2, 2, "BPL"},
-	[0x50] = {_bvc, M_RELATIVE, 2, 2, "BVC"},
-	[0x70] = {_bvs, M_RELATIVE, 2, 2, "BVS"},
-
-	[0x18] = {_clc, M_IMPLIED, 2, 1, "CLC"},
-	[0xD8] = {_cld, M_IMPLIED, 2, 1, "CLD"},
-	[0x58] = {_cli, M_IMPLIED, 2, 1, "CLI"},
-	[0xB8] = {_clv, M_IMPLIED, 2, 1, "CLV"},
-
-	[0xC9] = {_cmp, M_IMMEDIATE, 2, 2, "CMP"},
-	[0xC5] = {_cmp, M_ZEROPAGE, 3, 2, "CMP"},
-	[0xD5] = {_cmp, M_ZEROPAGE_X, 4, 2, "CMP"},
-	[0xCD] = {_cmp, M_ABSOLUTE, 4, 3, "CMP"},
-	[0xDD] = {_cmp, M_ABSOLUTE_X, 4, 3, "CMP"},
-	[0xD9] = {_cmp, M_ABSOLUTE_Y, 4, 3, "CMP"},
-	[0xC1] = {_cmp, M_INDIRECT_X, 6, 2, "CMP"},
-	[0xD1] = {_cmp, M_INDIRECT_Y, 5, 2, "CMP"},
-
-	[0xE0] = {_cpx, M_IMMEDIATE, 2, 2, "CPX"},
-	[0xE4] = {_cpx, M_ZEROPAGE, 3, 2, "CPX"},
-	[0xEC] = {_cpx, M_ABSOLUTE, 4, 3, "CPX"},
-
-	[0xC0] = {_cpy, M_IMMEDIATE, 2, 2, "CPY"},
-	[0xC4] = {_cpy, M_ZEROPAGE, 3, 2, "CPY"},
-	[0xCC] = {_cpy, M_ABSOLUTE, 4, 3, "CPY"},
-
-	[0xC7] = {_dcp, M_ZEROPAGE, 5, 2, "*DCP"},
-	[0xD7] = {_dcp, M_ZEROPAGE_X, 6, 2, "*DCP"},
-	[0xCF] = {_dcp, M_ABSOLUTE, 6, 3, "*DCP"},
-	[0xDF] = {_dcp, M_ABSOLUTE_X, 7, 3, "*DCP"},
-	[0xDB] = {_dcp, M_ABSOLUTE_Y, 7, 3, "*DCP"},
-	[0xC3] = {_dcp, M_INDIRECT_X, 8, 2, "*DCP"},
-	[0xD3] = {_dcp, M_INDIRECT_Y, 8, 2, "*DCP"},
-
-	[0xC6] = {_dec, M_ZEROPAGE, 5, 2, "DEC"},
-	[0xD6] = {_dec, M_ZEROPAGE_X, 6, 2, "DEC"},
-	[0xCE] = {_dec, M_ABSOLUTE, 6, 3, "DEC"},
-	[0xDE] = {_dec, M_ABSOLUTE_X, 7, 3, "DEC"},
-
-	[0xCA] = {_dex, M_IMPLIED, 2, 1, "DEX"},
-	[0x88] = {_dey, M_IMPLIED, 2, 1, "DEY"},
-
-	[0x49] = {_eor, M_IMMEDIATE, 2, 2, "EOR"},
-	[0x45] = {_eor, M_ZEROPAGE, 3, 2, "EOR"},
-	[0x55] = {_eor, M_ZEROPAGE_X, 4, 2, "EOR"},
-	[0x4D] = {_eor, M_ABSOLUTE, 4, 3, "EOR"},
-	[0x5D] = {_eor, M_ABSOLUTE_X, 4, 3, "EOR"},
-	[0x59] = {_eor, M_ABSOLUTE_Y, 4, 3, "EOR"},
-	[0x41] = {_eor, M_INDIRECT_X, 6, 2, "EOR"},
-	[0x51] = {_eor, M_INDIRECT_Y, 5, 2, "EOR"},
-
-	[0xE6] = {_inc, M_ZEROPAGE, 5, 2, "INC"},
-	[0xF6] = {_inc, M_ZEROPAGE_X, 6, 2, "INC"},
-	[0xEE] = {_inc, M_ABSOLUTE, 6, 3, "INC"},
-	[0xFE] = {_inc, M_ABSOLUTE_X, 7, 3, "INC"},
-
-	[0xE8] = {_inx, M_IMPLIED, 2, 1, "INX"},
-	[0xC8] = {_iny, M_IMPLIED, 2, 1, "INY"},
-
-	[0xE7] = {_isb, M_ZEROPAGE, 5, 2, "*ISB"},
-	[0xF7] = {_isb, M_ZEROPAGE_X, 6, 2, "*ISB"},
-	[0xEF] = {_isb, M_ABSOLUTE, 6, 3, "*ISB"},
-	[0xFF] = {_isb, M_ABSOLUTE_X, 7, 3, "*ISB"},
-	[0xFB] = {_isb, M_ABSOLUTE_Y, 7, 3, "*ISB"},
-	[0xE3] = {_isb, M_INDIRECT_X, 8, 2, "*ISB"},
-	[0xF3] = {_isb, M_INDIRECT_Y, 8, 2, "*ISB"},
-
-	[0x4C] = {_jmp, M_ABSOLUTE, 3, 3, "JMP"},
-	[0x6C] = {_jmp, M_INDIRECT, 5, 3, "JMP"},
-
-	[0x20] = {_jsr, M_ABSOLUTE, 6, 3, "JSR"},
-
-	[0xBB] = {_las, M_ABSOLUTE_Y, 4, 3, "*LAS"},
-
-	[0xA7] = {_lax, M_ZEROPAGE, 3, 2, "*LAX"},
-	[0xB7] = {_lax, M_ZEROPAGE_Y, 4, 2, "*LAX"},
-	[0xAF] = {_lax, M_ABSOLUTE, 4, 3, "*LAX"},
-	[0xBF] = {_lax, M_ABSOLUTE_Y, 4, 3, "*LAX"},
-	[0xA3] = {_lax, M_INDIRECT_X, 6, 2, "*LAX"},
-	[0xB3] = {_lax, M_INDIRECT_Y, 5, 2, "*LAX"},
-
-	[0xA9] = {_lda, M_IMMEDIATE, 2, 2, "LDA"},
-	[0xA5] = {_lda, M_ZEROPAGE, 3, 2, "LDA"},
-	[0xB5] = {_lda, M_ZEROPAGE_X, 4, 2, "LDA"},
-	[0xAD] = {_lda, M_ABSOLUTE, 4, 3, "LDA"},
-	[0xBD] = {_lda, M_ABSOLUTE_X, 4, 3, "LDA"},
-	[0xB9] = {_lda, M_ABSOLUTE_Y, 4, 3, "LDA"},
-	[0xA1] = {_lda, M_INDIRECT_X, 6, 2, "LDA"},
-	[0xB1] = {_lda, M_INDIRECT_Y, 5, 2, "LDA"},
-
-	[0xA2] = {_ldx, M_IMMEDIATE, 2, 2, "LDX"},
-	[0xA6] = {_ldx, M_ZEROPAGE, 3, 2, "LDX"},
-	[0xB6] = {_ldx, M_ZEROPAGE_Y, 4, 2, "LDX"},
-	[0xAE] = {_ldx, M_ABSOLUTE, 4, 3, "LDX"},
-	[0xBE] = {_ldx, M_ABSOLUTE_Y, 4, 3, "LDX"},
-
-	[0xA0] = {_ldy, M_IMMEDIATE, 2, 2, "LDY"},
-	[0xA4] = {_ldy, M_ZEROPAGE, 3, 2, "LDY"},
-	[0xB4] = {_ldy, M_ZEROPAGE_X, 4, 2, "LDY"},
-	[0xAC] = {_ldy, M_ABSOLUTE, 4, 3, "LDY"},
-	[0xBC] = {_ldy, M_ABSOLUTE_X, 4, 3, "LDY"},
-
-	[0x4A] = {_lsr, M_IMPLIED, 2, 1, "LSR"},
-	[0x46] = {_lsr, M_ZEROPAGE, 5, 2, "LSR"},
-	[0x56] = {_lsr, M_ZEROPAGE_X, 6, 2, "LSR"},
-	[0x4E] = {_lsr, M_ABSOLUTE, 6, 3, "LSR"},
-	[0x5E] = {_lsr, M_ABSOLUTE_X, 7, 3, "LSR"},
-
-	[0xEA] = {_nop, M_IMPLIED, 2, 1, "NOP"},
-
-	[0x1A] = {_nop, M_IMPLIED, 2, 1, "*NOP"}, /* Unofficial NOPs */
-	[0x3A] = {_nop, M_IMPLIED, 2, 1, "*NOP"},
-	[0x5A] = {_nop, M_IMPLIED, 2, 1, "*NOP"},
-	[0x7A] = {_nop, M_IMPLIED, 2, 1, "*NOP"},
-	[0xDA] = {_nop, M_IMPLIED, 2, 1, "*NOP"},
-	[0xFA] = {_nop, M_IMPLIED, 2, 1, "*NOP"},
-
-	[0x04] = {_nop, M_ZEROPAGE, 3, 2, "*NOP"}, /* DOP (double NOP) */
-	[0x14] = {_nop, M_ZEROPAGE_X, 4, 2, "*NOP"},
-	[0x34] = {_nop, M_ZEROPAGE_X, 4, 2, "*NOP"},
-	[0x44] = {_nop, M_ZEROPAGE, 3, 2, "*NOP"},
-	[0x54] = {_nop, M_ZEROPAGE_X, 4, 2, "*NOP"},
-	[0x64] = {_nop, M_ZEROPAGE, 3, 2, "*NOP"},
-	[0x74] = {_nop, M_ZEROPAGE_X, 4, 2, "*NOP"},
-	[0x80] = {_nop, M_IMMEDIATE, 2, 2, "*NOP"},
-	[0x82] = {_nop, M_IMMEDIATE, 2, 2, "*NOP"},
-	[0x89] = {_nop, M_IMMEDIATE, 2, 2, "*NOP"},
-	[0xC2] = {_nop, M_IMMEDIATE, 2, 2, "*NOP"},
-	[0xD4] = {_nop, M_ZEROPAGE_X, 4, 2, "*NOP"},
-	[0xE2] = {_nop, M_IMMEDIATE, 2, 2, "*NOP"},
-	[0xF4] = {_nop, M_ZEROPAGE_X, 4, 2, "*NOP"},
-
-	[0x0C] = {_nop, M_ABSOLUTE, 4, 3, "*NOP"}, /* TOP (triple NOP) */
-	[0x1C] = {_nop, M_ABSOLUTE_X, 4, 3, "*NOP"},
-	[0x3C] = {_nop, M_ABSOLUTE_X, 4, 3, "*NOP"},
-	[0x5C] = {_nop, M_ABSOLUTE_X, 4, 3, "*NOP"},
-	[0x7C] = {_nop, M_ABSOLUTE_X, 4, 3, "*NOP"},
-	[0xDC] = {_nop, M_ABSOLUTE_X, 4, 3, "*NOP"},
-	[0xFC] = {_nop, M_ABSOLUTE_X, 4, 3, "*NOP"},
-
-	[0x09] = {_ora, M_IMMEDIATE, 2, 2, "ORA"},
-	[0x05] = {_ora, M_ZEROPAGE, 3, 2, "ORA"},
-	[0x15] = {_ora, M_ZEROPAGE_X, 4, 2, "ORA"},
-	[0x0D] = {_ora, M_ABSOLUTE, 4, 3, "ORA"},
-	[0x1D] = {_ora, M_ABSOLUTE_X, 4, 3, "ORA"},
-	[0x19] = {_ora, M_ABSOLUTE_Y, 4, 3, "ORA"},
-	[0x01] = {_ora, M_INDIRECT_X, 6, 2, "ORA"},
-	[0x11] = {_ora, M_INDIRECT_Y, 5, 2, "ORA"},
-
-	[0x48] = {_pha, M_IMPLIED, 3, 1, "PHA"},
-	[0x08] = {_php, M_IMPLIED, 3, 1, "PHP"},
-	[0x68] = {_pla, M_IMPLIED, 4, 1, "PLA"},
-	[0x28] = {_plp, M_IMPLIED, 4, 1, "PLP"},
-
-	[0x27] = {_rla, M_ZEROPAGE, 5, 2, "*RLA"},
-	[0x37] = {_rla, M_ZEROPAGE_X, 6, 2, "*RLA"},
-	[0x2F] = {_rla, M_ABSOLUTE, 6, 3, "*RLA"},
-	[0x3F] = {_rla, M_ABSOLUTE_X, 7, 3, "*RLA"},
-	[0x3B] = {_rla, M_ABSOLUTE_Y, 7, 3, "*RLA"},
-	[0x23] = {_rla, M_INDIRECT_X, 8, 2, "*RLA"},
-	[0x33] = {_rla, M_INDIRECT_Y, 8, 2, "*RLA"},
-
-	[0x67] = {_rra, M_ZEROPAGE, 5, 2, "*RRA"},
-	[0x77] = {_rra, M_ZEROPAGE_X, 6, 2, "*RRA"},
-	[0x6F] = {_rra, M_ABSOLUTE, 6, 3, "*RRA"},
-	[0x7F] = {_rra, M_ABSOLUTE_X, 7, 3, "*RRA"},
-	[0x7B] = {_rra, M_ABSOLUTE_Y, 7, 3, "*RRA"},
-	[0x63] = {_rra, M_INDIRECT_X, 8, 2, "*RRA"},
-	[0x73] = {_rra, M_INDIRECT_Y, 8, 2, "*RRA"},
-
-	[0x2A] = {_rol, M_IMPLIED, 2, 1, "ROL"},
-	[0x26] = {_rol, M_ZEROPAGE, 5, 2, "ROL"},
-	[0x36] = {_rol, M_ZEROPAGE_X, 6, 2, "ROL"},
-	[0x2E] = {_rol, M_ABSOLUTE, 6, 3, "ROL"},
-	[0x3E] = {_rol, M_ABSOLUTE_X, 7, 3, "ROL"},
-
-	[0x6A] = {_ror, M_IMPLIED, 2, 1, "ROR"},
-	[0x66] = {_ror, M_ZEROPAGE, 5, 2, "ROR"},
-	[0x76] = {_ror, M_ZEROPAGE_X, 6, 2, "ROR"},
-	[0x6E] = {_ror, M_ABSOLUTE, 6, 3, "ROR"},
-	[0x7E] = {_ror, M_ABSOLUTE_X, 7, 3, "ROR"},
-
-	[0x40] = {_rti, M_IMPLIED, 6, 1, "RTI"},
-	[0x60] = {_rts, M_IMPLIED, 6, 1, "RTS"},
-
-	[0x87] = {_sax, M_ZEROPAGE, 3, 2, "*SAX"},
-	[0x97] = {_sax, M_ZEROPAGE_Y, 4, 2, "*SAX"},
-	[0x83] = {_sax, M_INDIRECT_X, 6, 2, "*SAX"},
-	[0x8F] = {_sax, M_ABSOLUTE, 4, 3, "*SAX"},
-
-	[0xE9] = {_sbc, M_IMMEDIATE, 2, 2, "SBC"},
-	[0xEB] = {_sbc, M_IMMEDIATE, 2, 2, "*SBC"},
-
-	[0xE5] = {_sbc, M_ZEROPAGE, 3, 2, "SBC"},
-	[0xF5] = {_sbc, M_ZEROPAGE_X, 4, 2, "SBC"},
-	[0xED] = {_sbc, M_ABSOLUTE, 4, 3, "SBC"},
-	[0xFD] = {_sbc, M_ABSOLUTE_X, 4, 3, "SBC"},
-	[0xF9] = {_sbc, M_ABSOLUTE_Y, 4, 3, "SBC"},
-	[0xE1] = {_sbc, M_INDIRECT_X, 6, 2, "SBC"},
-	[0xF1] = {_sbc, M_INDIRECT_Y, 5, 2, "SBC"},
-
-	[0x38] = {_sec, M_IMPLIED, 2, 1, "SEC"},
-	[0xF8] = {_sed, M_IMPLIED, 2, 1, "SED"},
-	[0x78] = {_sei, M_IMPLIED, 2, 1, "SEI"},
-
-	[0x9E] = {_shx, M_ABSOLUTE_Y, 3, 3, "*SHX"},
-	[0x9C] = {_shy, M_ABSOLUTE_X, 5, 3, "*SHY"},
-
-	[0x07] = {_slo, M_ZEROPAGE, 5, 2, "*SLO"},
-	[0x17] = {_slo, M_ZEROPAGE_X, 6, 2, "*SLO"},
-	[0x0F] = {_slo, M_ABSOLUTE, 6, 3, "*SLO"},
-	[0x1F] = {_slo, M_ABSOLUTE_X, 7, 3, "*SLO"},
-	[0x1B] = {_slo, M_ABSOLUTE_Y, 7, 3, "*SLO"},
-	[0x03] = {_slo, M_INDIRECT_X, 8, 2, "*SLO"},
-	[0x13] = {_slo, M_INDIRECT_Y, 8, 2, "*SLO"},
-
-	[0x47] = {_sre, M_ZEROPAGE, 5, 2, "*SLO"},
-	[0x57] = {_sre, M_ZEROPAGE_X, 6, 2, "*SLO"},
-	[0x4F] = {_sre, M_ABSOLUTE, 6, 3, "*SLO"},
-	[0x5F] = {_sre, M_ABSOLUTE_X, 7, 3, "*SLO"},
-	[0x5B] = {_sre, M_ABSOLUTE_Y, 7, 3, "*SLO"},
-	[0x43] = {_sre, M_INDIRECT_X, 8, 2, "*SLO"},
-	[0x53] = {_sre, M_INDIRECT_Y, 8, 2, "*SLO"},
-
-	[0x85] = {_sta, M_ZEROPAGE, 3, 2, "STA"},
-	[0x95] = {_sta, M_ZEROPAGE_X, 4, 2, "STA"},
-	[0x8D] = {_sta, M_ABSOLUTE, 4, 3, "STA"},
-	[0x9D] = {_sta, M_ABSOLUTE_X, 5, 3, "STA"},
-	[0x99] = {_sta, M_ABSOLUTE_Y, 5, 3, "STA"},
-	[0x81] = {_sta, M_INDIRECT_X, 6, 2, "STA"},
-	[0x91] = {_sta, M_INDIRECT_Y, 6, 2, "STA"},
-
-	[0x86] = {_stx, M_ZEROPAGE, 3, 2, "STX"},
-	[0x96] = {_stx, M_ZEROPAGE_Y, 4, 2, "STX"},
-	[0x8E] = {_stx, M_ABSOLUTE, 4, 3, "STX"},
-
-	[0x84] = {_sty, M_ZEROPAGE, 3, 2, "STY"},
-	[0x94] = {_sty, M_ZEROPAGE_X, 4, 2, "STY"},
-	[0x8C] = {_sty, M_ABSOLUTE, 4, 3, "STY"},
-
-	[0x9B] = {_tas, M_ABSOLUTE_Y, 5, 3, "*TAS"},
-
-	[0xAA] = {_tax, M_IMPLIED, 2, 1, "TAX"},
-	[0xA8] = {_tay, M_IMPLIED, 2, 1, "TAY"},
-	[0xBA] = {_tsx, M_IMPLIED, 2, 1, "TSX"},
-	[0x8A] = {_txa, M_IMPLIED, 2, 1, "TXA"},
-	[0x9A] = {_txs, M_IMPLIED, 2, 1, "TXS"},
-	[0x98] = {_tya, M_IMPLIED, 2, 1, "TYA"},
-
-	[0x8B] = {_xaa, M_IMMEDIATE, 2, 2, "*XAA"},
+/* Specialized handlers, one per opcode
+ *
+ * They're generated from CPU_OPS, so the addressing mode, cycles and length of
+ * each one are compile-time constants: the generic handler gets inlined, the
+ * mode switch folds away, and the PC is moved past the operand up front
+ *
+ * _execXX runs the instruction with an operand that's already been fetched
+ * (e.g. from the decode cache), while _opXX fetches it first
+ */
+#define OP_SPECIALIZE(CODE, FN, MODE, CYCLES, BYTES, NAME)         \
+	static inline void _exec##CODE(CPU *cpu, const uint16_t ARG) { \
+		FN(cpu, MODE, ARG);                                        \
+		busTick(&cpu->bus, CYCLES);                                \
+	}                                                              \
+                                                                   \
+	static inline void _op##CODE(CPU *cpu) {                       \
+		_exec##CODE(cpu, _fetchOperand(cpu, BYTES));               \
+	}
+
+CPU_OPS(OP_SPECIALIZE)
+
+#undef OP_SPECIALIZE
+
+#define OP_ENTRY(CODE, FN, MODE, CYCLES, BYTES, NAME) \
+	[CODE] = {_op##CODE, _exec##CODE, MODE, CYCLES, BYTES, NAME},
+
+static const Op OPS[256] = {CPU_OPS(OP_ENTRY)};
+
+#undef OP_ENTRY
+
+/* Idle loop fast-forwarding
+ *
+ * Games tend to wait for the NMI by spinning on something like LDA $2002 / BPL
+ * or LDA zp / BEQ. Only the CPU writes RAM, and the vblank flag only changes on
+ * a scheduled event, so until the next one every iteration sees the same value
+ * and leaves the CPU exactly as the previous one did. Those iterations are
+ * skipped by moving the clock forward instead of running them
+ */
+/* Returns the address read by the load at HEAD, or -1 if it's not one idle
+ * loops are made of
+ */
+static int32_t _idleLoadAddress(CPU *cpu, const uint16_t HEAD) {
+	switch( busRead(&cpu->bus, HEAD) ) {
+		case 0x24: /* BIT zp */
+		case 0xA4: /* LDY zp */
+		case 0xA5: /* LDA zp */
+		case 0xA6: /* LDX zp */
+			return busRead(&cpu->bus, (uint16_t)(HEAD + 1));
+
+		case 0x2C: /* BIT abs */
+		case 0xAC: /* LDY abs */
+		case 0xAD: /* LDA abs */
+		case 0xAE: /* LDX abs */
+			return busRead16(&cpu->bus, (uint16_t)(HEAD + 1));
+
+		default:
+			return -1;
+	}
+}
+
+/* Whether loading VALUE again would leave the registers as they are. It won't
+ * if e.g. an NMI came in between the load and the branch
+ */
+static bool _idleLoadIsSteady(CPU *cpu, const uint8_t LOAD,
+							  const uint8_t VALUE) {
+	const bool NEGATIVE = (VALUE & SIGN_BIT) != 0;
+	uint8_t reg = 0;
+
+	switch( LOAD ) {
+		case 0x24:
+		case 0x2C:
+			return _isZero(cpu) == ((cpu->regA & VALUE) == 0) &&
+				   _isNegative(cpu) == NEGATIVE &&
+				   cpu->status.overflow == ((VALUE >> 6) & 1);
+
+		case 0xA4:
+		case 0xAC:
+			reg = cpu->regY;
+			break;
+
+		case 0xA5:
+		case 0xAD:
+			reg = cpu->regA;
+			break;
+
+		default:
+			reg = cpu->regX;
+			break;
+	}
+
+	return reg == VALUE && _isZero(cpu) == (VALUE == 0) &&
+		   _isNegative(cpu) == NEGATIVE;
+}
+
+bool cpuIsIdleLoop(CPU *cpu, const uint16_t HEAD) {
+	/* Anything else could be I/O, and reading it would have side effects */
+	if( HEAD >= 0x2000 && HEAD < 0x8000 ) {
+		return false;
+	}
+
+	const int32_t ADDRESS = _idleLoadAddress(cpu, HEAD);
+	if( ADDRESS < 0 ) {
+		return false;
+	}
+
+	const uint8_t LOAD = busRead(&cpu->bus, HEAD);
+	const uint16_t BRANCH_PC = (uint16_t)(HEAD + OPS[LOAD].bytes);
+	const uint8_t BRANCH = busRead(&cpu->bus, BRANCH_PC);
+	const int8_t OFFSET = (int8_t)busRead(&cpu->bus, (uint16_t)(BRANCH_PC + 1));
+
+	if( (uint16_t)(BRANCH_PC + 2 + OFFSET) != HEAD ) {
+		return false;
+	}
+
+	const bool IS_RAM = ADDRESS < 0x2000;
+	const bool IS_STATUS = (ADDRESS & 0xE007) == 0x2002;
+
+	switch( BRANCH ) {
+		case 0x10: /* BPL */
+		case 0x30: /* BMI */
+			/* Sprite 0 hit and overflow can change at any time, but vblank
+			 * (bit 7) only changes on an event
+			 */
+			return IS_RAM || IS_STATUS;
+
+		case 0xD0: /* BNE */
+		case 0xF0: /* BEQ */
+			return IS_RAM;
+
+		default:
+			return false;
+	}
+}
+
+void cpuSkipIdleLoop(CPU *cpu, const uint8_t PENDING) {
+	if( cpu->watches != NULL ) {
+		return;
+	}
+
+	const uint16_t HEAD = cpu->pc;
+	const uint8_t LOAD = busRead(&cpu->bus, HEAD);
+	const uint16_t BRANCH_PC = (uint16_t)(HEAD + OPS[LOAD].bytes);
+	const uint8_t BRANCH = busRead(&cpu->bus, BRANCH_PC);
+
+	/* The branch is always taken, and may cross back to the head's page */
+	const uint16_t AFTER = (uint16_t)(BRANCH_PC + 2);
+	const size_t TAKEN = 1 + (size_t)((AFTER ^ HEAD) > 0xFF);
+	const size_t ITERATION =
+		(size_t)(OPS[LOAD].cycles + OPS[BRANCH].cycles) + TAKEN;
+	const size_t NOW = cpu->bus.cycles + PENDING;
+	const size_t NEXT = cpu->bus.sched.next;
+
+	/* The last skipped iteration has to end before the event is due, so the
+	 * one that runs into it is still interpreted
+	 */
+	if( NEXT == SCHED_NEVER || NOW + ITERATION >= NEXT ) {
+		return;
+	}
+
+	const uint16_t ADDRESS = (uint16_t)_idleLoadAddress(cpu, HEAD);
+	uint8_t value = 0;
+
+	if( ADDRESS < 0x2000 ) {
+		value = cpu->bus.cpuVRAM[ADDRESS & 0x07FF];
+	} else {
+		/* Reading the status while vblank is set would clear it */
+		busSyncPPU(&cpu->bus);
+		value = cpu->bus.ppu.status.bits;
+
+		if( (value & SIGN_BIT) != 0 ) {
+			return;
+		}
+	}
+
+	if( !_idleLoadIsSteady(cpu, LOAD, value) ) {
+		return;
+	}
+
+	const size_t SKIPPED = (NEXT - 1 - NOW) / ITERATION * ITERATION;
+
+	cpu->bus.cycles += SKIPPED;
+	cpu->idleCycles += SKIPPED;
+}
+
+static NOINLINE void _branchBack(CPU *cpu) {
+	const uint16_t HEAD = cpu->pc;
+
+	if( cpuIsIdleLoop(cpu, HEAD) ) {
+		/* The branch itself is only ticked once it's done */
+		const uint8_t LOAD = busRead(&cpu->bus, HEAD);
+		const uint16_t BRANCH_PC = (uint16_t)(HEAD + OPS[LOAD].bytes);
+
+		cpuSkipIdleLoop(cpu, OPS[busRead(&cpu->bus, BRANCH_PC)].cycles);
+	}
+}
+
+/* Pre-decoded instruction cache
+ *
+ * PRG ROM doesn't change while a bank is mapped, so each instruction in
+ * $8000-$FFFF is only fetched and decoded once. Entries remember the stamp of
+ * the PRG window they came from, and are re-decoded once it's remapped
+ */
+#define DECODE_BASE 0x8000
+#define DECODE_SIZE 0x8000
+
+struct _DecodedOp {
+	OpExecFn exec;
+	uint32_t stamp;
+	uint16_t arg;
+	uint8_t opcode;
+	uint8_t bytes;
+	uint8_t cycles;
 };
 
+/* Returns the decoded instruction at the PC, decoding it if needed. Returns
+ * NULL for instructions that aren't cached (outside of PRG ROM, BRK and KIL)
+ */
+static inline const DecodedOp *_decode(CPU *cpu) {
+	const uint16_t PC = cpu->pc;
+
+	if( PC < DECODE_BASE || cpu->decoded == NULL ) {
+		return NULL;
+	}
+
+	const uint16_t OFFSET = PC - DECODE_BASE;
+	const uint8_t WINDOW = (uint8_t)(OFFSET / BUS_PRG_WINDOW_SIZE);
+	const uint32_t STAMP = cpu->bus.prgStamps[WINDOW];
+
+	DecodedOp *entry = &cpu->decoded[OFFSET];
+	if( entry->stamp == STAMP ) {
+		return entry;
+	}
+
+	const uint8_t OPCODE = busRead(&cpu->bus, PC);
+	const Op *OP = &OPS[OPCODE];
+
+	if( OP->exec == NULL ) {
+		return NULL;
+	}
+
+	entry->exec = OP->exec;
+	entry->opcode = OPCODE;
+	entry->bytes = OP->bytes;
+	entry->cycles = OP->cycles;
+
+	switch( OP->bytes ) {
+		case 2:
+			entry->arg = busRead(&cpu->bus, (uint16_t)(PC + 1));
+			break;
+		case 3:
+			entry->arg = busRead16(&cpu->bus, (uint16_t)(PC + 1));
+			break;
+		default:
+			entry->arg = 0;
+			break;
+	}
+
+	/* Operands that spill into the next window would go stale without this
+	 * one noticing, so those are never marked as valid
+	 */
+	const bool SPILLS =
+		(OFFSET % BUS_PRG_WINDOW_SIZE) + OP->bytes > BUS_PRG_WINDOW_SIZE;
+	entry->stamp = SPILLS ? 0 : STAMP;
+
+	return entry;
+}
+
 void cpuReset(CPU *cpu) {
 	cpu->regA = 0;
 	cpu->regX = 0;
 	cpu->regY = 0;
 
-	cpu->status.bits = 0;
-	cpu->status.interrupt = 1;
+	cpuSetStatus(cpu, 0);
+	_setIntr(cpu);
 	cpu->status.bFlag2 = 1;
 
 	cpu->stack = 0xFD;
+	cpu->idleCycles = 0;
+	cpu->decoded = NULL;
+	cpu->jit = NULL;
 }
 
-void cpuInit(CPU *cpu, Bus bus) {
+void cpuInitFromROM(CPU *cpu, const ROM *CART) {
+	/* The bus goes first, since resetting the status tells it about I */
+	busInit(&cpu->bus, CART, &cpu->pendingEvents, _gameCallback);
 	cpuReset(cpu);
-
-	cpu->bus = bus;
-	cpu->bus.callback = _gameCallback;
+	cpu->watches = NULL;
+	cpu->trace = NULL;
 }
 
-void cpuInitFromROM(CPU *cpu, ROM rom) {
-	cpuReset(cpu);
-	busInit(&cpu->bus, rom, _gameCallback);
+/* Only accesses to pages with a watch on them go looking for callbacks */
+static ALWAYS_INLINE bool _isWatched(CPU *cpu, const WatchKind KIND,
+									 const uint16_t ADDRESS) {
+	return cpu->watches != NULL &&
+		   (cpu->watches->pages[ADDRESS >> 8] & KIND) != 0;
 }
 
 uint8_t cpuRead(CPU *cpu, const uint16_t ADDRESS) {
-	if( ADDRESS == 0x2001 ) {
-		printf("aha @ %04X\n", cpu->pc);
+	const uint8_t VALUE = busRead(&cpu->bus, ADDRESS);
+
+	if( _isWatched(cpu, WATCH_READ, ADDRESS) ) {
+		watchNotify(cpu, WATCH_READ, ADDRESS, VALUE);
 	}
-	return busRead(&cpu->bus, ADDRESS);
+
+	return VALUE;
 }
 
 uint16_t cpuRead16(CPU *cpu, const uint16_t ADDRESS) {
-	if( ADDRESS == 0x2001 ) {
-		printf("aha @ %04X\n", cpu->pc);
+	if( cpu->watches != NULL ) {
+		const uint16_t LO = cpuRead(cpu, ADDRESS);
+		return (uint16_t)(LO | (cpuRead(cpu, ADDRESS + 1) << 8));
 	}
+
 	return busRead16(&cpu->bus, ADDRESS);
 }
 
 void cpuWrite(CPU *cpu, const uint16_t ADDRESS, const uint8_t VALUE) {
 	busWrite(&cpu->bus, ADDRESS, VALUE);
+
+	if( _isWatched(cpu, WATCH_WRITE, ADDRESS) ) {
+		watchNotify(cpu, WATCH_WRITE, ADDRESS, VALUE);
+	}
 }
 
 void cpuWrite16(CPU *cpu, const uint16_t ADDRESS, const uint16_t VALUE) {
@@ -1523,12 +1504,9 @@ void cpuLoad(CPU *cpu, const uint8_t *CODE, const uint16_t SIZE) {
 
 void cpuLoadAndRun(CPU *cpu, const uint8_t *CODE, const uint16_t SIZE) {
 	ROM rom;
-	romInit(&rom, CODE);
-
-	Bus bus;
-	busInit(&bus, rom, _gameCallback);
+	romCreateTestROM(&rom);
 
-	cpuInit(cpu, bus);
+	cpuInitFromROM(cpu, &rom);
 	cpuLoad(cpu, CODE, SIZE);
 	cpuRun(cpu);
 }
@@ -1565,153 +1543,427 @@ static bool _handleInput(CPU *cpu) {
 }
 */
 
-void cpuTrace(CPU *cpu, const Op OP) {
-	printf("%04X  ", --cpu->pc);
+/* Execution trace */
 
-	switch( OP.bytes ) {
-		case 1:
-			printf("%02X       ", cpuRead(cpu, cpu->pc));
-			break;
+static const Op BRK_OP = {NULL, NULL, M_IMPLIED, 7, 1, "BRK"};
+static const Op KIL_OP = {NULL, NULL, M_IMPLIED, 7, 1, "*KIL"};
+
+static const Op *_traceOp(const uint8_t OPCODE) {
+	if( OPS[OPCODE].NAME[0] != '\0' ) {
+		return &OPS[OPCODE];
+	}
+
+	return (OPCODE == 0x00) ? &BRK_OP : &KIL_OP;
+}
+
+static void _traceFill(CPU *cpu, TraceRecord *record, const uint16_t PC,
+					   const DecodedOp *DECODED) {
+	record->cycles = cpu->bus.cycles;
+	record->pc = PC;
+
+	record->regA = cpu->regA;
+	record->regX = cpu->regX;
+	record->regY = cpu->regY;
+	record->stack = cpu->stack;
+
+	record->status = cpu->status.bits;
+	record->zeroResult = cpu->zeroResult;
+	record->negResult = cpu->negResult;
+
+	if( DECODED != NULL ) {
+		record->opcode = DECODED->opcode;
+		record->operands[0] = (uint8_t)(DECODED->arg & 0xFF);
+		record->operands[1] = (uint8_t)(DECODED->arg >> 8);
+		return;
+	}
+
+	uint8_t bytes[3];
+	busPeekRange(&cpu->bus, PC, bytes, sizeof(bytes));
+
+	record->opcode = bytes[0];
+	record->operands[0] = bytes[1];
+	record->operands[1] = bytes[2];
+}
+
+static ALWAYS_INLINE void _traceStep(CPU *cpu, const DecodedOp *DECODED) {
+	if( cpu->trace != NULL ) {
+		_traceFill(cpu, traceNext(cpu->trace), cpu->pc, DECODED);
+	}
+}
+
+void cpuTraceRecord(CPU *cpu) {
+	_traceStep(cpu, NULL);
+}
+
+void cpuTraceEnable(CPU *cpu) {
+	if( cpu->trace == NULL ) {
+		cpu->trace = traceCreate();
+	}
+}
+
+void cpuTraceDisable(CPU *cpu) {
+	traceDestroy(cpu->trace);
+	cpu->trace = NULL;
+}
+
+void cpuTraceFormat(const TraceRecord *RECORD, char *out, const size_t SIZE) {
+	const Op *OP = _traceOp(RECORD->opcode);
+
+	const uint8_t LO = RECORD->operands[0];
+	const uint8_t HI = RECORD->operands[1];
+	const uint16_t WORD = (uint16_t)(LO | (HI << 8));
+
+	char bytes[9];
+	switch( OP->bytes ) {
 		case 2:
-			printf("%02X %02X    ", cpuRead(cpu, cpu->pc),
-				   cpuRead(cpu, cpu->pc + 1));
+			snprintf(bytes, sizeof(bytes), "%02X %02X", RECORD->opcode, LO);
 			break;
 		case 3:
-			printf("%02X %02X %02X ", cpuRead(cpu, cpu->pc),
-				   cpuRead(cpu, cpu->pc + 1), cpuRead(cpu, cpu->pc + 2));
+			snprintf(bytes, sizeof(bytes), "%02X %02X %02X", RECORD->opcode,
+					 LO, HI);
 			break;
 		default:
-			errPrint(C_YELLOW, "Bad OP @ pc=%04X %02X, dumping info:\n",
-					 cpu->pc, cpuRead(cpu, cpu->pc));
-			printf(" * Addressing mode.. %02X\n", OP.mode);
-			printf(" * Cycles........... %02X\n", OP.cycles);
-			printf(" * Bytes............ %02X\n", OP.bytes);
-			printf(" * Mnemonic......... %s\n", OP.NAME);
+			snprintf(bytes, sizeof(bytes), "%02X", RECORD->opcode);
 			break;
 	}
 
-	if( OP.NAME[0] != '*' ) {
-		putchar(' ');
-	}
-
-	printf("%s ", OP.NAME);
-
-	switch( OP.mode ) {
+	/* Only what the record itself holds, as memory may have changed since */
+	char operand[29] = "";
+	switch( OP->mode ) {
 		case M_IMMEDIATE:
-			printf("#$%02X                        ", cpuRead(cpu, ++cpu->pc));
+			snprintf(operand, sizeof(operand), "#$%02X", LO);
 			break;
 
-		case M_ZEROPAGE: {
-			const uint8_t ADDRESS = cpuRead(cpu, ++cpu->pc);
-			printf("$%02X                         ", ADDRESS);
-		} break;
+		case M_ZEROPAGE:
+			snprintf(operand, sizeof(operand), "$%02X", LO);
+			break;
 
-		case M_ZEROPAGE_X: {
-			const uint8_t ADDRESS = cpuRead(cpu, ++cpu->pc);
-			const uint16_t COMPUTED = _getAddressFromMode(cpu, OP.mode);
-			--cpu->pc;
-			printf("$%02X,X @ %02x                  ", ADDRESS, COMPUTED);
-		} break;
+		case M_ZEROPAGE_X:
+			snprintf(operand, sizeof(operand), "$%02X,X @ %02X", LO,
+					 (uint8_t)(LO + RECORD->regX));
+			break;
 
-		case M_ZEROPAGE_Y: {
-			const uint8_t ADDRESS = cpuRead(cpu, ++cpu->pc);
-			const uint16_t COMPUTED = _getAddressFromMode(cpu, OP.mode);
-			printf("$%02X,Y @ %02X                  ", ADDRESS, COMPUTED);
-		} break;
+		case M_ZEROPAGE_Y:
+			snprintf(operand, sizeof(operand), "$%02X,Y @ %02X", LO,
+					 (uint8_t)(LO + RECORD->regY));
+			break;
 
 		case M_RELATIVE:
-			printf("$%02X                       ",
-				   cpu->pc + cpuRead(cpu, cpu->pc + 1) + 2);
-			++cpu->pc;
+			snprintf(operand, sizeof(operand), "$%04X",
+					 (uint16_t)(RECORD->pc + OP->bytes + (int8_t)LO));
 			break;
 
-		case M_ABSOLUTE: {
-			++cpu->pc;
-			const uint16_t ADDRESS = _getAddressFromMode(cpu, OP.mode);
-			cpu->pc -= 2;
-			printf("$%04X                       ", ADDRESS);
-		} break;
-
-		case M_ABSOLUTE_X: {
-			const uint16_t ADDRESS = cpuRead16(cpu, ++cpu->pc);
-			const uint16_t COMPUTED = _getAddressFromMode(cpu, OP.mode);
-			cpu->pc -= 2;
-			printf("$%04X,X @ %04X              ", ADDRESS, COMPUTED);
-		} break;
-
-		case M_ABSOLUTE_Y: {
-			const uint16_t ADDRESS = cpuRead16(cpu, ++cpu->pc);
-			const uint16_t COMPUTED = _getAddressFromMode(cpu, OP.mode);
-			cpu->pc -= 2;
-			printf("$%04X,Y @ %04X              ", ADDRESS, COMPUTED);
-		} break;
+		case M_ABSOLUTE:
+			snprintf(operand, sizeof(operand), "$%04X", WORD);
+			break;
 
-		case M_INDIRECT: {
-			const uint16_t ADDRESS = cpuRead16(cpu, ++cpu->pc);
-			printf("($%04X)                     ", ADDRESS);
-		} break;
+		case M_ABSOLUTE_X:
+			snprintf(operand, sizeof(operand), "$%04X,X @ %04X", WORD,
+					 (uint16_t)(WORD + RECORD->regX));
+			break;
 
-		case M_INDIRECT_X: {
-			const uint16_t ADDRESS = cpuRead(cpu, ++cpu->pc);
-			printf("($%02X,X) @ %02X                ", ADDRESS,
-				   (ADDRESS + cpu->regX) & 0xFF);
-		} break;
+		case M_ABSOLUTE_Y:
+			snprintf(operand, sizeof(operand), "$%04X,Y @ %04X", WORD,
+					 (uint16_t)(WORD + RECORD->regY));
+			break;
 
-		case M_INDIRECT_Y: {
-			const uint16_t ADDRESS = cpuRead(cpu, ++cpu->pc);
-			const uint16_t COMPUTED = _getAddressFromMode(cpu, OP.mode);
-			--cpu->pc;
-			printf("($%02X),Y = %04X @ %04X       ", ADDRESS,
-				   (COMPUTED - cpu->regY), COMPUTED);
-		} break;
+		case M_INDIRECT:
+			snprintf(operand, sizeof(operand), "($%04X)", WORD);
+			break;
 
-		case M_IMPLIED:
-			printf("                            ");
-			++cpu->pc;
+		case M_INDIRECT_X:
+			snprintf(operand, sizeof(operand), "($%02X,X) @ %02X", LO,
+					 (uint8_t)(LO + RECORD->regX));
+			break;
+
+		case M_INDIRECT_Y:
+			snprintf(operand, sizeof(operand), "($%02X),Y", LO);
 			break;
 
 		default:
 			break;
 	}
 
-	printf("A:%02X X:%02X Y:%02X P:%02X SP:%02X\n", cpu->regA, cpu->regX,
-		   cpu->regY, cpu->status.bits, cpu->stack);
+	CPUStatus status = {.bits = RECORD->status};
+	status.zero = RECORD->zeroResult == 0;
+	status.negative = (RECORD->negResult & SIGN_BIT) != 0;
+
+	snprintf(out, SIZE,
+			 "%04X  %-8s %4s %-28sA:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%zu",
+			 RECORD->pc, bytes, OP->NAME, operand, RECORD->regA, RECORD->regX,
+			 RECORD->regY, status.bits, RECORD->stack, RECORD->cycles);
+}
+
+void cpuTraceDump(CPU *cpu, FILE *out, const size_t LAST) {
+	char line[128];
+
+	for( size_t ago = LAST; ago > 0; --ago ) {
+		const TraceRecord *RECORD = traceGet(cpu->trace, ago - 1);
+		if( RECORD == NULL ) {
+			continue;
+		}
+
+		cpuTraceFormat(RECORD, line, sizeof(line));
+		fprintf(out, "%s\n", line);
+	}
+}
+
+/* Stops on BRK and KIL, showing how the CPU got there if it's being traced,
+ * or just where it stopped otherwise
+ */
+static void _halt(CPU *cpu) {
+	if( cpu->trace != NULL ) {
+		cpuTraceDump(cpu, stdout, TRACE_DUMP_LAST);
+		return;
+	}
+
+	TraceRecord record;
+	_traceFill(cpu, &record, (uint16_t)(cpu->pc - 1), NULL);
+
+	char line[128];
+	cpuTraceFormat(&record, line, sizeof(line));
+	printf("%s\n", line);
+}
+
+static void _dumpRunning(void) {
+	if( gRunning != NULL && gRunning->trace != NULL ) {
+		fprintf(stderr, "Last instructions before exiting:\n");
+		cpuTraceDump(gRunning, stderr, TRACE_DUMP_LAST);
+	}
+
+	gRunning = NULL;
+}
+
+static void _dumpOnSignal(int sig) {
+	_dumpRunning();
+
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+static void _installCrashDump(void) {
+	static bool installed = false;
+	if( installed ) {
+		return;
+	}
+
+	installed = true;
+	atexit(_dumpRunning);
+
+	signal(SIGSEGV, _dumpOnSignal);
+	signal(SIGILL, _dumpOnSignal);
+	signal(SIGFPE, _dumpOnSignal);
+	signal(SIGABRT, _dumpOnSignal);
 }
 
-static void _interruptNMI(CPU *cpu) {
+/* Pushes the PC and status (with B clear) and jumps through VECTOR */
+static void _interrupt(CPU *cpu, const uint16_t VECTOR) {
 	_push16(cpu, cpu->pc);
 
-	CPUStatus status = cpu->status;
+	CPUStatus status = {.bits = cpuGetStatus(cpu)};
 	status.bFlag1 = 0;
 	status.bFlag2 = 1;
 
 	_push(cpu, status.bits);
-	cpu->status.interrupt = 1;
+	_setIntr(cpu);
 
 	busTick(&cpu->bus, 2);
 
-	cpu->bus.ppu.nmiInterrupt = false;
+	cpu->pc = _readVector(cpu, VECTOR);
+}
 
-	cpu->pc = cpuRead16(cpu, 0xFFFA);
+/* NMI is edge triggered, so taking it clears it. The IRQ line is level
+ * triggered: it's taken before every instruction for as long as a device
+ * holds it and interrupts aren't disabled. The bus only flags it while I is
+ * clear, but an NMI can set I first
+ */
+static NOINLINE void _serviceEvents(CPU *cpu) {
+	if( (cpu->pendingEvents & PENDING_NMI) != 0 ) {
+		cpu->bus.ppu.nmiInterrupt = false;
+		cpu->pendingEvents &= (uint8_t)~PENDING_NMI;
+
+		_interrupt(cpu, 0xFFFA);
+	} else if( !cpu->status.interrupt ) {
+		_interrupt(cpu, 0xFFFE);
+	}
 }
 
-void cpuRun(CPU *cpu) {
-	srand((unsigned int)time(NULL));
+static ALWAYS_INLINE void _pollInterrupts(CPU *cpu) {
+	if( UNLIKELY(cpu->pendingEvents != 0) ) {
+		_serviceEvents(cpu);
+	}
+}
+
+/* Lets execute watches know about the instruction at the PC. Fetches count as
+ * executes, never as reads
+ */
+static ALWAYS_INLINE void _watchExec(CPU *cpu) {
+	if( _isWatched(cpu, WATCH_EXEC, cpu->pc) ) {
+		watchNotify(cpu, WATCH_EXEC, cpu->pc, busRead(&cpu->bus, cpu->pc));
+	}
+}
 
-	cpu->pc = cpuRead16(cpu, 0xFFFC);
-	register uint16_t pcState = 0;
+/* Runs as many compiled blocks as it can, servicing NMIs in between */
+static inline void _runBlocks(CPU *cpu) {
+#ifdef NESINC_JIT
+	while( jitRun(cpu) ) {
+		_pollInterrupts(cpu);
+	}
+#else
+	UNUSED(cpu);
+#endif
+}
+
+#ifdef NESINC_THREADED_DISPATCH
+
+/* The cached instruction at the PC, as long as nothing needs looking at
+ * before it runs: no pending event, watch, trace or JIT, and a valid decode
+ * cache entry. NULL means the dispatcher has to take the slow path
+ */
+static ALWAYS_INLINE const DecodedOp *_fastOp(CPU *cpu) {
+	if( cpu->pendingEvents != 0 || cpu->watches != NULL ||
+		cpu->trace != NULL ) {
+		return NULL;
+	}
+
+#ifdef NESINC_JIT
+	if( cpu->jit != NULL ) {
+		return NULL;
+	}
+#endif
+
+	const uint16_t PC = cpu->pc;
+	if( PC < DECODE_BASE || cpu->decoded == NULL ) {
+		return NULL;
+	}
+
+	const uint16_t OFFSET = PC - DECODE_BASE;
+	const DecodedOp *ENTRY = &cpu->decoded[OFFSET];
+
+	if( ENTRY->stamp != cpu->bus.prgStamps[OFFSET / BUS_PRG_WINDOW_SIZE] ) {
+		return NULL;
+	}
 
+	return ENTRY;
+}
+
+/* Everything else _runSwitch does before an instruction. It's kept out of
+ * line so the 256 copies of the dispatch only carry _fastOp. Returns the
+ * decoded instruction, or NULL with the opcode fetched into OPCODE
+ */
+static NOINLINE const DecodedOp *_slowOp(CPU *cpu, uint8_t *opcode) {
+	_pollInterrupts(cpu);
+	_runBlocks(cpu);
+	_watchExec(cpu);
+
+	const DecodedOp *DECODED = _decode(cpu);
+	_traceStep(cpu, DECODED);
+	if( DECODED == NULL ) {
+		*opcode = busRead(&cpu->bus, cpu->pc++);
+	}
+
+	return DECODED;
+}
+
+/* Threaded-code dispatcher
+ *
+ * Every opcode gets its own label, with its handler, addressing mode, cycles
+ * and length baked in. Once it's done, it jumps straight to the label of the
+ * next opcode through a computed goto, instead of going back to a switch
+ */
+static void _runThreaded(CPU *cpu) {
+#define OP_LABEL(CODE, FN, MODE, CYCLES, BYTES, NAME) [CODE] = &&L##CODE,
+#define EXEC_LABEL(CODE, FN, MODE, CYCLES, BYTES, NAME) [CODE] = &&E##CODE,
+
+	static const void *const LABELS[256] = {
+		CPU_OPS(OP_LABEL)
+
+		[0x00] = &&L_BRK,
+
+		[0x02] = &&L_KIL,
+		[0x12] = &&L_KIL,
+		[0x22] = &&L_KIL,
+		[0x32] = &&L_KIL,
+		[0x42] = &&L_KIL,
+		[0x52] = &&L_KIL,
+		[0x62] = &&L_KIL,
+		[0x72] = &&L_KIL,
+		[0x92] = &&L_KIL,
+		[0xB2] = &&L_KIL,
+		[0xD2] = &&L_KIL,
+		[0xF2] = &&L_KIL,
+	};
+
+	/* Entry points for instructions coming from the decode cache, which skip
+	 * the operand fetch
+	 */
+	static const void *const EXEC_LABELS[256] = {CPU_OPS(EXEC_LABEL)};
+
+#undef EXEC_LABEL
+#undef OP_LABEL
+
+	uint16_t arg = 0;
+	uint8_t next = 0;
+
+#define DISPATCH()                               \
+	do {                                         \
+		const DecodedOp *DECODED = _fastOp(cpu); \
+		if( UNLIKELY(DECODED == NULL) ) {        \
+			DECODED = _slowOp(cpu, &next);       \
+			if( DECODED == NULL ) {              \
+				goto *LABELS[next];              \
+			}                                    \
+		}                                        \
+                                                 \
+		cpu->pc += DECODED->bytes;               \
+		arg = DECODED->arg;                      \
+		goto *EXEC_LABELS[DECODED->opcode];      \
+	} while( false )
+
+#define OP_HANDLER(CODE, FN, MODE, CYCLES, BYTES, NAME) \
+	L##CODE:                                            \
+	arg = _fetchOperand(cpu, BYTES);                    \
+	E##CODE:                                            \
+	_exec##CODE(cpu, arg);                              \
+	DISPATCH();
+
+	DISPATCH();
+
+	CPU_OPS(OP_HANDLER)
+
+L_BRK:
+	_halt(cpu);
+	return;
+
+L_KIL:
+	_halt(cpu);
+	return;
+
+#undef OP_HANDLER
+#undef DISPATCH
+}
+
+#else
+
+static void _runSwitch(CPU *cpu) {
 	while( true ) {
-		if( cpu->bus.ppu.nmiInterrupt ) {
-			_interruptNMI(cpu);
+		_pollInterrupts(cpu);
+		_runBlocks(cpu);
+		_watchExec(cpu);
+
+		const DecodedOp *DECODED = _decode(cpu);
+		_traceStep(cpu, DECODED);
+		if( DECODED != NULL ) {
+			cpu->pc += DECODED->bytes;
+			DECODED->exec(cpu, DECODED->arg);
+			continue;
 		}
 
-		const uint8_t OP = cpuRead(cpu, cpu->pc++);
-		pcState = cpu->pc;
+		const uint8_t OP = busRead(&cpu->bus, cpu->pc++);
 
 		switch( OP ) {
 			case 0x00: /* BRK */
-				cpuTrace(cpu, (Op){NULL, M_IMPLIED, 7, 1, "BRK"});
+				_halt(cpu);
 				return;
 			case 0x02:	// KIL
 			case 0x12:	// Unnoficial opcode, works basically the same as BRK
@@ -1725,18 +1977,45 @@ void cpuRun(CPU *cpu) {
 			case 0xB2:
 			case 0xD2:
 			case 0xF2:
-				cpuTrace(cpu, (Op){NULL, M_IMPLIED, 7, 1, "*KIL"});
+				_halt(cpu);
 				return;
 
-			default: {
-				const Op OPERATION = OPS[OP];
-				OPERATION.fn(cpu, OPERATION.mode);
-
-				busTick(&cpu->bus, OPERATION.cycles);
-				if( pcState == cpu->pc ) {
-					cpu->pc += (uint16_t)(OPERATION.bytes - 1);
-				}
-			}
+			default:
+				OPS[OP].fn(cpu);
+				break;
 		}
 	}
 }
+
+#endif
+
+void cpuRun(CPU *cpu) {
+	srand((unsigned int)time(NULL));
+
+	cpu->pc = _readVector(cpu, 0xFFFC);
+	cpu->decoded = calloc(DECODE_SIZE, sizeof(DecodedOp));
+#ifdef NESINC_JIT
+	cpu->jit = jitCreate();
+#endif
+
+	_installCrashDump();
+	gRunning = cpu;
+
+#ifdef NESINC_THREADED_DISPATCH
+	_runThreaded(cpu);
+#else
+	_runSwitch(cpu);
+#endif
+
+	gRunning = NULL;
+
+	free(cpu->decoded);
+	cpu->decoded = NULL;
+#ifdef NESINC_JIT
+	jitDestroy(cpu->jit);
+	cpu->jit = NULL;
+#endif
+
+	/* Leaves status.bits up to date for whoever looks at it next */
+	cpuGetStatus(cpu);
+}
@@ -0,0 +1,10 @@
+#include "cpu_alu.h"
+
+#include "cpu.h"
+
+#define ZN1(V) (uint8_t)(((V) == 0 ? ZERO_BIT : 0) | ((V) & SIGN_BIT))
+#define ZN4(V) ZN1(V), ZN1((V) + 1), ZN1((V) + 2), ZN1((V) + 3)
+#define ZN16(V) ZN4(V), ZN4((V) + 4), ZN4((V) + 8), ZN4((V) + 12)
+#define ZN64(V) ZN16(V), ZN16((V) + 16), ZN16((V) + 32), ZN16((V) + 48)
+
+const uint8_t ALU_ZN[256] = {ZN64(0), ZN64(64), ZN64(128), ZN64(192)};
@@ -0,0 +1,1358 @@
+#include "cpu_jit.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "cpu_alu.h"
+#include "cpu_ops.h"
+#include "error.h"
+
+#if !defined(__x86_64__) && !defined(_M_X64)
+#error "The JIT can only be built for x86-64"
+#endif
+
+/* Generated code always follows the System V calling convention, so the same
+ * emitter works on Windows too
+ */
+#define JIT_ABI __attribute__((sysv_abi))
+
+#define JIT_BASE 0x8000
+#define JIT_SIZE 0x8000
+
+#define JIT_CODE_SIZE (4 * 1024 * 1024)
+#define JIT_BLOCK_CODE_MAX 0x4000
+
+/* Blocks hand their cycles to busTick in one go, which takes them as a byte */
+#define JIT_BLOCK_CYCLES_MAX UINT8_MAX
+#define JIT_PENALTY_MAX 2 /* A taken branch onto another page */
+#define JIT_BLOCK_OPS_MAX 32
+
+#define P_CARRY CARRY_BIT
+#define P_ZERO ZERO_BIT
+#define P_INTR 0x04
+#define P_DECIMAL 0x08
+
+typedef void(JIT_ABI *JitBlockFn)(CPU *cpu);
+
+typedef struct _JitBlock {
+	JitBlockFn fn;
+	uint32_t stamp;
+	uint8_t cycles; /* With every penalty taken */
+	bool idle;		/* See cpuIsIdleLoop */
+} JitBlock;
+
+struct _Jit {
+	uint8_t *code;
+	size_t used;
+
+	JitBlock blocks[JIT_SIZE];
+};
+
+typedef struct _JitOpInfo {
+	AddressingMode mode;
+	uint8_t cycles;
+	uint8_t bytes;
+} JitOpInfo;
+
+#define OP_INFO(CODE, FN, MODE, CYCLES, BYTES, NAME) \
+	[CODE] = {MODE, CYCLES, BYTES},
+
+static const JitOpInfo OPS[256] = {CPU_OPS(OP_INFO)};
+
+#undef OP_INFO
+
+/* - - - Emitter - - - */
+
+typedef enum {
+	RAX,
+	RCX,
+	RDX,
+	RBX,
+	RSP,
+	RBP,
+	RSI,
+	RDI,
+	R8,
+	R9,
+	R10,
+	R11,
+	R12,
+	R13,
+	R14,
+	R15,
+} HostReg;
+
+#define NO_INDEX -1
+
+/* Where the CPU state lives while a block runs. All of them are callee-saved,
+ * so they survive calls back into the bus
+ */
+#define REG_CPU RBX
+#define REG_PENDING RBP /* Cycles not handed to busTick yet */
+#define REG_A R12
+#define REG_X R13
+#define REG_Y R14
+#define REG_P R15
+
+#define OFF_A (int32_t)offsetof(CPU, regA)
+#define OFF_X (int32_t)offsetof(CPU, regX)
+#define OFF_Y (int32_t)offsetof(CPU, regY)
+#define OFF_PC (int32_t)offsetof(CPU, pc)
+#define OFF_P (int32_t)offsetof(CPU, status)
+#define OFF_STACK (int32_t)offsetof(CPU, stack)
+#define OFF_ZERO_RESULT (int32_t)offsetof(CPU, zeroResult)
+#define OFF_NEG_RESULT (int32_t)offsetof(CPU, negResult)
+#define OFF_RAM (int32_t)offsetof(CPU, bus.cpuVRAM)
+#define OFF_PENDING (int32_t)offsetof(CPU, pendingEvents)
+#define OFF_PRG_STAMPS (int32_t)offsetof(CPU, bus.prgStamps)
+
+typedef enum {
+	ALU_ADD = 0,
+	ALU_OR = 1,
+	ALU_AND = 4,
+	ALU_SUB = 5,
+	ALU_XOR = 6,
+	ALU_CMP = 7,
+} AluOp;
+
+typedef enum {
+	SHIFT_SHL = 4,
+	SHIFT_SHR = 5,
+} ShiftOp;
+
+typedef enum {
+	CC_AE = 0x3,
+	CC_Z = 0x4,
+	CC_NZ = 0x5,
+} Cond;
+
+typedef struct _Emitter {
+	uint8_t *p;
+	uint8_t penalty; /* Most extra cycles the last op can take */
+} Emitter;
+
+static void _emit8(Emitter *e, const int VALUE) {
+	*e->p++ = (uint8_t)VALUE;
+}
+
+static void _emit32(Emitter *e, const int32_t VALUE) {
+	memcpy(e->p, &VALUE, sizeof(VALUE));
+	e->p += sizeof(VALUE);
+}
+
+static void _emit64(Emitter *e, const uint64_t VALUE) {
+	memcpy(e->p, &VALUE, sizeof(VALUE));
+	e->p += sizeof(VALUE);
+}
+
+/* Always emitted, so byte registers never mean AH-DH */
+static void _rex(Emitter *e, const bool W, const int REG, const int INDEX,
+				 const int BASE) {
+	const int X = (INDEX == NO_INDEX) ? 0 : INDEX;
+	_emit8(e, 0x40 | (W << 3) | ((REG >> 3) << 2) | ((X >> 3) << 1) |
+				  (BASE >> 3));
+}
+
+static void _modrmReg(Emitter *e, const int REG, const int RM) {
+	_emit8(e, 0xC0 | ((REG & 7) << 3) | (RM & 7));
+}
+
+/* [rbx + INDEX + DISP] */
+static void _modrmMem(Emitter *e, const int REG, const int INDEX,
+					  const int32_t DISP) {
+	if( INDEX == NO_INDEX ) {
+		_emit8(e, 0x80 | ((REG & 7) << 3) | REG_CPU);
+	} else {
+		_emit8(e, 0x80 | ((REG & 7) << 3) | 0x04);
+		_emit8(e, ((INDEX & 7) << 3) | REG_CPU);
+	}
+
+	_emit32(e, DISP);
+}
+
+/* movzx DST, byte [rbx + INDEX + DISP] */
+static void _loadByte(Emitter *e, const int DST, const int INDEX,
+					  const int32_t DISP) {
+	_rex(e, false, DST, INDEX, 0);
+	_emit8(e, 0x0F);
+	_emit8(e, 0xB6);
+	_modrmMem(e, DST, INDEX, DISP);
+}
+
+/* mov byte [rbx + INDEX + DISP], SRC */
+static void _storeByte(Emitter *e, const int SRC, const int INDEX,
+					   const int32_t DISP) {
+	_rex(e, false, SRC, INDEX, 0);
+	_emit8(e, 0x88);
+	_modrmMem(e, SRC, INDEX, DISP);
+}
+
+/* mov word [rbx + DISP], SRC */
+static void _storeWord(Emitter *e, const int SRC, const int32_t DISP) {
+	_emit8(e, 0x66);
+	_rex(e, false, SRC, NO_INDEX, 0);
+	_emit8(e, 0x89);
+	_modrmMem(e, SRC, NO_INDEX, DISP);
+}
+
+/* cmp byte [rbx + DISP], VALUE */
+static void _cmpByte(Emitter *e, const int32_t DISP, const uint8_t VALUE) {
+	_rex(e, false, 0, NO_INDEX, 0);
+	_emit8(e, 0x80);
+	_modrmMem(e, ALU_CMP, NO_INDEX, DISP);
+	_emit8(e, VALUE);
+}
+
+static void _cmpDword(Emitter *e, const int32_t DISP, const uint32_t VALUE) {
+	_rex(e, false, 0, NO_INDEX, 0);
+	_emit8(e, 0x81);
+	_modrmMem(e, ALU_CMP, NO_INDEX, DISP);
+	_emit32(e, (int32_t)VALUE);
+}
+
+/* mov DST, SRC */
+static void _mov(Emitter *e, const int DST, const int SRC) {
+	_rex(e, false, SRC, NO_INDEX, DST);
+	_emit8(e, 0x89);
+	_modrmReg(e, SRC, DST);
+}
+
+/* mov DST, SRC (64 bits) */
+static void _mov64(Emitter *e, const int DST, const int SRC) {
+	_rex(e, true, SRC, NO_INDEX, DST);
+	_emit8(e, 0x89);
+	_modrmReg(e, SRC, DST);
+}
+
+/* mov DST, VALUE */
+static void _movImm(Emitter *e, const int DST, const int32_t VALUE) {
+	_rex(e, false, 0, NO_INDEX, DST);
+	_emit8(e, 0xB8 | (DST & 7));
+	_emit32(e, VALUE);
+}
+
+/* <OP> DST, VALUE */
+static void _aluImm(Emitter *e, const AluOp OP, const int DST,
+					const int32_t VALUE) {
+	_rex(e, false, 0, NO_INDEX, DST);
+	_emit8(e, 0x81);
+	_modrmReg(e, OP, DST);
+	_emit32(e, VALUE);
+}
+
+/* <OP> DST, VALUE (64 bits) */
+static void _aluImm64(Emitter *e, const AluOp OP, const int DST,
+					  const int32_t VALUE) {
+	_rex(e, true, 0, NO_INDEX, DST);
+	_emit8(e, 0x81);
+	_modrmReg(e, OP, DST);
+	_emit32(e, VALUE);
+}
+
+/* <OP> DST, SRC */
+static void _alu(Emitter *e, const AluOp OP, const int DST, const int SRC) {
+	_rex(e, false, SRC, NO_INDEX, DST);
+	_emit8(e, ((int)OP << 3) | 0x01);
+	_modrmReg(e, SRC, DST);
+}
+
+/* shl/shr DST, COUNT */
+static void _shift(Emitter *e, const ShiftOp OP, const int DST,
+				   const uint8_t COUNT) {
+	_rex(e, false, 0, NO_INDEX, DST);
+	_emit8(e, 0xC1);
+	_modrmReg(e, OP, DST);
+	_emit8(e, COUNT);
+}
+
+/* movzx DST, SRC (low byte) */
+static void _zext8(Emitter *e, const int DST, const int SRC) {
+	_rex(e, false, DST, NO_INDEX, SRC);
+	_emit8(e, 0x0F);
+	_emit8(e, 0xB6);
+	_modrmReg(e, DST, SRC);
+}
+
+/* movzx DST, SRC (low word) */
+static void _zext16(Emitter *e, const int DST, const int SRC) {
+	_rex(e, false, DST, NO_INDEX, SRC);
+	_emit8(e, 0x0F);
+	_emit8(e, 0xB7);
+	_modrmReg(e, DST, SRC);
+}
+
+/* lea DST, [BASE + DISP] */
+static void _lea(Emitter *e, const int DST, const int BASE,
+				 const int32_t DISP) {
+	_rex(e, false, DST, NO_INDEX, BASE);
+	_emit8(e, 0x8D);
+	_emit8(e, 0x80 | ((DST & 7) << 3) | (BASE & 7));
+
+	if( (BASE & 7) == RSP ) {
+		_emit8(e, 0x24);
+	}
+
+	_emit32(e, DISP);
+}
+
+/* test DST (low byte), VALUE */
+static void _testImm8(Emitter *e, const int DST, const uint8_t VALUE) {
+	_rex(e, false, 0, NO_INDEX, DST);
+	_emit8(e, 0xF6);
+	_modrmReg(e, 0, DST);
+	_emit8(e, VALUE);
+}
+
+/* setcc DST (low byte) */
+static void _setcc(Emitter *e, const Cond CC, const int DST) {
+	_rex(e, false, 0, NO_INDEX, DST);
+	_emit8(e, 0x0F);
+	_emit8(e, 0x90 | (int)CC);
+	_modrmReg(e, 0, DST);
+}
+
+/* cmovcc DST, SRC */
+static void _cmov(Emitter *e, const Cond CC, const int DST, const int SRC) {
+	_rex(e, false, DST, NO_INDEX, SRC);
+	_emit8(e, 0x0F);
+	_emit8(e, 0x40 | (int)CC);
+	_modrmReg(e, DST, SRC);
+}
+
+static void _push(Emitter *e, const int REG) {
+	_rex(e, false, 0, NO_INDEX, REG);
+	_emit8(e, 0x50 | (REG & 7));
+}
+
+static void _pop(Emitter *e, const int REG) {
+	_rex(e, false, 0, NO_INDEX, REG);
+	_emit8(e, 0x58 | (REG & 7));
+}
+
+/* Emits a jump (or a conditional one) and returns where its offset goes, to
+ * be filled in by _patch once the target is known
+ */
+static uint8_t *_jcc(Emitter *e, const Cond CC) {
+	_emit8(e, 0x0F);
+	_emit8(e, 0x80 | (int)CC);
+
+	uint8_t *const AT = e->p;
+	_emit32(e, 0);
+
+	return AT;
+}
+
+static uint8_t *_jmp(Emitter *e) {
+	_emit8(e, 0xE9);
+
+	uint8_t *const AT = e->p;
+	_emit32(e, 0);
+
+	return AT;
+}
+
+static void _patch(Emitter *e, uint8_t *AT) {
+	const int32_t REL = (int32_t)(e->p - (AT + sizeof(int32_t)));
+	memcpy(AT, &REL, sizeof(REL));
+}
+
+/* mov rax, FN; call rax */
+static void _call(Emitter *e, const uintptr_t FN) {
+	_rex(e, true, 0, NO_INDEX, RAX);
+	_emit8(e, 0xB8);
+	_emit64(e, FN);
+
+	_emit8(e, 0xFF);
+	_emit8(e, 0xD0);
+}
+
+/* - - - Runtime helpers, called from generated code - - - */
+
+static JIT_ABI void _jitTick(CPU *cpu, const uint32_t PENDING) {
+	busTick(&cpu->bus, (uint8_t)PENDING);
+}
+
+/* Bus accesses tick the cycles of the previous instructions first, so I/O
+ * registers see the same timing as they would from the interpreter
+ */
+static JIT_ABI uint8_t _jitRead(CPU *cpu, const uint32_t ADDRESS,
+								const uint32_t PENDING) {
+	busTick(&cpu->bus, (uint8_t)PENDING);
+	return cpuRead(cpu, (uint16_t)ADDRESS);
+}
+
+static JIT_ABI void _jitWrite(CPU *cpu, const uint32_t ADDRESS,
+							  const uint32_t VALUE, const uint32_t PENDING) {
+	busTick(&cpu->bus, (uint8_t)PENDING);
+	cpuWrite(cpu, (uint16_t)ADDRESS, (uint8_t)VALUE);
+}
+
+/* - - - Code generation - - - */
+
+static void _emitPrologue(Emitter *e) {
+	_push(e, RBX);
+	_push(e, RBP);
+	_push(e, R12);
+	_push(e, R13);
+	_push(e, R14);
+	_push(e, R15);
+	_aluImm64(e, ALU_SUB, RSP, 8);
+
+	_mov64(e, REG_CPU, RDI);
+	_loadByte(e, REG_A, NO_INDEX, OFF_A);
+	_loadByte(e, REG_X, NO_INDEX, OFF_X);
+	_loadByte(e, REG_Y, NO_INDEX, OFF_Y);
+	_alu(e, ALU_XOR, REG_PENDING, REG_PENDING);
+
+	/* Blocks keep P whole, so the lazy zero and negative flags get folded in
+	 * on the way in and split back out on the way out
+	 */
+	_loadByte(e, REG_P, NO_INDEX, OFF_P);
+	_aluImm(e, ALU_AND, REG_P, (uint8_t)~(P_ZERO | SIGN_BIT));
+
+	_loadByte(e, RAX, NO_INDEX, OFF_NEG_RESULT);
+	_aluImm(e, ALU_AND, RAX, SIGN_BIT);
+	_alu(e, ALU_OR, REG_P, RAX);
+
+	_cmpByte(e, OFF_ZERO_RESULT, 0);
+	_setcc(e, CC_Z, RAX);
+	_zext8(e, RAX, RAX);
+	_shift(e, SHIFT_SHL, RAX, 1);
+	_alu(e, ALU_OR, REG_P, RAX);
+}
+
+/* Writes the registers back, ticks the remaining cycles and returns */
+static void _emitExit(Emitter *e) {
+	_storeByte(e, REG_A, NO_INDEX, OFF_A);
+	_storeByte(e, REG_X, NO_INDEX, OFF_X);
+	_storeByte(e, REG_Y, NO_INDEX, OFF_Y);
+	_storeByte(e, REG_P, NO_INDEX, OFF_P);
+
+	_storeByte(e, REG_P, NO_INDEX, OFF_NEG_RESULT);
+	_mov(e, RAX, REG_P);
+	_aluImm(e, ALU_AND, RAX, P_ZERO);
+	_aluImm(e, ALU_XOR, RAX, P_ZERO);
+	_storeByte(e, RAX, NO_INDEX, OFF_ZERO_RESULT);
+
+	_mov64(e, RDI, REG_CPU);
+	_mov(e, RSI, REG_PENDING);
+	_call(e, (uintptr_t)_jitTick);
+
+	_aluImm64(e, ALU_ADD, RSP, 8);
+	_pop(e, R15);
+	_pop(e, R14);
+	_pop(e, R13);
+	_pop(e, R12);
+	_pop(e, RBP);
+	_pop(e, RBX);
+	_emit8(e, 0xC3);
+}
+
+static void _emitExitTo(Emitter *e, const uint16_t PC) {
+	_movImm(e, RAX, PC);
+	_storeWord(e, RAX, OFF_PC);
+	_emitExit(e);
+}
+
+/* Leaves the block early if a write left an event pending (e.g. an NMI), so
+ * the interpreter can service it before the next instruction, or if it
+ * remapped the block's own PRG window, so the rest of it isn't run from the
+ * old bank
+ */
+static void _emitIOCheck(Emitter *e, const uint16_t NEXT, const uint8_t WINDOW,
+						 const uint32_t STAMP) {
+	_cmpByte(e, OFF_PENDING, 0);
+	uint8_t *const NOTHING_PENDING = _jcc(e, CC_Z);
+	_emitExitTo(e, NEXT);
+	_patch(e, NOTHING_PENDING);
+
+	_cmpDword(e, OFF_PRG_STAMPS + WINDOW * (int32_t)sizeof(uint32_t), STAMP);
+	uint8_t *const SAME_BANK = _jcc(e, CC_Z);
+	_emitExitTo(e, NEXT);
+	_patch(e, SAME_BANK);
+}
+
+/* Sets the zero and negative flags from the low byte of SRC. Clobbers EDX */
+static void _emitZN(Emitter *e, const int SRC) {
+	_aluImm(e, ALU_AND, REG_P, (uint8_t)~(P_ZERO | SIGN_BIT));
+
+	_mov(e, RDX, SRC);
+	_aluImm(e, ALU_AND, RDX, SIGN_BIT);
+	_alu(e, ALU_OR, REG_P, RDX);
+
+	_testImm8(e, SRC, 0xFF);
+	_setcc(e, CC_Z, RDX);
+	_zext8(e, RDX, RDX);
+	_shift(e, SHIFT_SHL, RDX, 1);
+	_alu(e, ALU_OR, REG_P, RDX);
+}
+
+/* Sets the zero and negative flags for a value known while compiling */
+static void _emitZNConst(Emitter *e, const uint8_t VALUE) {
+	_aluImm(e, ALU_AND, REG_P, (uint8_t)~(P_ZERO | SIGN_BIT));
+
+	if( ALU_ZN[VALUE] != 0 ) {
+		_aluImm(e, ALU_OR, REG_P, ALU_ZN[VALUE]);
+	}
+}
+
+/* Copies bit BIT of SRC into the carry flag. Clobbers EDX */
+static void _emitCarryFromBit(Emitter *e, const int SRC, const uint8_t BIT) {
+	_mov(e, RDX, SRC);
+	if( BIT != 0 ) {
+		_shift(e, SHIFT_SHR, RDX, BIT);
+	}
+	_aluImm(e, ALU_AND, RDX, P_CARRY);
+
+	_aluImm(e, ALU_AND, REG_P, (uint8_t)~P_CARRY);
+	_alu(e, ALU_OR, REG_P, RDX);
+}
+
+typedef enum {
+	ADDR_CONST,	  /* Known while compiling */
+	ADDR_RAM,	  /* RAM offset in ECX */
+	ADDR_DYNAMIC, /* Any address, in ECX */
+} AddrKind;
+
+/* Emits the effective address computation for MODE. Pointers always live in
+ * the zero page, so they're read straight from RAM
+ */
+static AddrKind _emitAddress(Emitter *e, const AddressingMode MODE,
+							 const uint16_t ARG, uint16_t *address) {
+	switch( MODE ) {
+		case M_ZEROPAGE:
+		case M_ABSOLUTE:
+			*address = ARG;
+			return ADDR_CONST;
+
+		case M_ZEROPAGE_X:
+		case M_ZEROPAGE_Y:
+			_lea(e, RCX, (MODE == M_ZEROPAGE_X) ? REG_X : REG_Y, ARG);
+			_zext8(e, RCX, RCX);
+			return ADDR_RAM;
+
+		case M_ABSOLUTE_X:
+		case M_ABSOLUTE_Y:
+			_lea(e, RCX, (MODE == M_ABSOLUTE_X) ? REG_X : REG_Y, ARG);
+			_zext16(e, RCX, RCX);
+			return ADDR_DYNAMIC;
+
+		case M_INDIRECT_X:
+			_lea(e, RAX, REG_X, ARG);
+			_zext8(e, RAX, RAX);
+			_loadByte(e, RCX, RAX, OFF_RAM);
+			_lea(e, RDX, RAX, 1);
+			_zext8(e, RDX, RDX);
+			_loadByte(e, RDX, RDX, OFF_RAM);
+			_shift(e, SHIFT_SHL, RDX, 8);
+			_alu(e, ALU_OR, RCX, RDX);
+			return ADDR_DYNAMIC;
+
+		case M_INDIRECT_Y:
+			_loadByte(e, RCX, NO_INDEX, OFF_RAM + (ARG & 0xFF));
+			_loadByte(e, RDX, NO_INDEX, OFF_RAM + ((ARG + 1) & 0xFF));
+			_shift(e, SHIFT_SHL, RDX, 8);
+			_alu(e, ALU_OR, RCX, RDX);
+			_alu(e, ALU_ADD, RCX, REG_Y);
+			_zext16(e, RCX, RCX);
+			return ADDR_DYNAMIC;
+
+		default:
+			errPrint(C_RED, "JIT: unexpected addressing mode %u", MODE);
+			exit(3);
+	}
+}
+
+static void _emitSlowRead(Emitter *e) {
+	_mov64(e, RDI, REG_CPU);
+	_mov(e, RDX, REG_PENDING);
+	_call(e, (uintptr_t)_jitRead);
+	_zext8(e, RAX, RAX);
+	_alu(e, ALU_XOR, REG_PENDING, REG_PENDING);
+}
+
+static void _emitSlowWrite(Emitter *e, const int SRC) {
+	_mov64(e, RDI, REG_CPU);
+	_mov(e, RDX, SRC);
+	_mov(e, RCX, REG_PENDING);
+	_call(e, (uintptr_t)_jitWrite);
+	_alu(e, ALU_XOR, REG_PENDING, REG_PENDING);
+}
+
+/* Charges an indexed read a cycle if the index carries into the high byte.
+ * The carry out of the low byte is added to the pending cycles as is, so
+ * there's no branch. Clobbers EDX
+ */
+static void _emitPageCross(Emitter *e, const AddressingMode MODE,
+						   const uint16_t ARG) {
+	switch( MODE ) {
+		case M_ABSOLUTE_X:
+		case M_ABSOLUTE_Y:
+			_lea(e, RDX, (MODE == M_ABSOLUTE_X) ? REG_X : REG_Y, ARG & 0xFF);
+			break;
+
+		case M_INDIRECT_Y:
+			_loadByte(e, RDX, NO_INDEX, OFF_RAM + (ARG & 0xFF));
+			_alu(e, ALU_ADD, RDX, REG_Y);
+			break;
+
+		default:
+			return;
+	}
+
+	_shift(e, SHIFT_SHR, RDX, 8);
+	_alu(e, ALU_ADD, REG_PENDING, RDX);
+	e->penalty = 1;
+}
+
+/* Reads an operand into EAX. RAM is accessed directly, everything else goes
+ * through the bus
+ */
+static void _emitRead(Emitter *e, const AddressingMode MODE,
+					  const uint16_t ARG) {
+	if( MODE == M_IMMEDIATE ) {
+		_movImm(e, RAX, ARG & 0xFF);
+		return;
+	}
+
+	_emitPageCross(e, MODE, ARG);
+
+	uint16_t address = 0;
+
+	switch( _emitAddress(e, MODE, ARG, &address) ) {
+		case ADDR_CONST:
+			if( address < 0x2000 ) {
+				_loadByte(e, RAX, NO_INDEX, OFF_RAM + (address & 0x07FF));
+			} else {
+				_movImm(e, RSI, address);
+				_emitSlowRead(e);
+			}
+			break;
+
+		case ADDR_RAM:
+			_loadByte(e, RAX, RCX, OFF_RAM);
+			break;
+
+		case ADDR_DYNAMIC: {
+			_aluImm(e, ALU_CMP, RCX, 0x2000);
+			uint8_t *const SLOW = _jcc(e, CC_AE);
+
+			_aluImm(e, ALU_AND, RCX, 0x07FF);
+			_loadByte(e, RAX, RCX, OFF_RAM);
+			uint8_t *const DONE = _jmp(e);
+
+			_patch(e, SLOW);
+			_mov(e, RSI, RCX);
+			_emitSlowRead(e);
+
+			_patch(e, DONE);
+		} break;
+	}
+}
+
+/* Loads an operand into REG for LDA, LDX and LDY. Immediates get their flags
+ * worked out while compiling
+ */
+static void _emitLoad(Emitter *e, const int REG, const AddressingMode MODE,
+					  const uint16_t ARG) {
+	if( MODE == M_IMMEDIATE ) {
+		_movImm(e, REG, ARG & 0xFF);
+		_emitZNConst(e, (uint8_t)ARG);
+		return;
+	}
+
+	_emitRead(e, MODE, ARG);
+	_mov(e, REG, RAX);
+	_emitZN(e, REG);
+}
+
+/* Writes SRC to an operand. Returns true if the write may reach I/O */
+static bool _emitWrite(Emitter *e, const AddressingMode MODE,
+					   const uint16_t ARG, const int SRC) {
+	uint16_t address = 0;
+
+	switch( _emitAddress(e, MODE, ARG, &address) ) {
+		case ADDR_CONST:
+			if( address < 0x2000 ) {
+				_storeByte(e, SRC, NO_INDEX, OFF_RAM + (address & 0x07FF));
+				return false;
+			}
+
+			_movImm(e, RSI, address);
+			_emitSlowWrite(e, SRC);
+			return true;
+
+		case ADDR_RAM:
+			_storeByte(e, SRC, RCX, OFF_RAM);
+			return false;
+
+		case ADDR_DYNAMIC:
+		default: {
+			_aluImm(e, ALU_CMP, RCX, 0x2000);
+			uint8_t *const SLOW = _jcc(e, CC_AE);
+
+			_aluImm(e, ALU_AND, RCX, 0x07FF);
+			_storeByte(e, SRC, RCX, OFF_RAM);
+			uint8_t *const DONE = _jmp(e);
+
+			_patch(e, SLOW);
+			_mov(e, RSI, RCX);
+			_emitSlowWrite(e, SRC);
+
+			_patch(e, DONE);
+			return true;
+		}
+	}
+}
+
+/* Pushes AL onto the stack. Clobbers ECX */
+static void _emitPush(Emitter *e) {
+	_loadByte(e, RCX, NO_INDEX, OFF_STACK);
+	_storeByte(e, RAX, RCX, OFF_RAM + 0x0100);
+	_lea(e, RCX, RCX, -1);
+	_storeByte(e, RCX, NO_INDEX, OFF_STACK);
+}
+
+/* Pulls a byte from the stack into EAX. Clobbers ECX */
+static void _emitPull(Emitter *e) {
+	_loadByte(e, RCX, NO_INDEX, OFF_STACK);
+	_lea(e, RCX, RCX, 1);
+	_zext8(e, RCX, RCX);
+	_storeByte(e, RCX, NO_INDEX, OFF_STACK);
+	_loadByte(e, RAX, RCX, OFF_RAM + 0x0100);
+}
+
+/* A = A + EAX + C */
+static void _emitAdc(Emitter *e) {
+	_mov(e, RCX, REG_P);
+	_aluImm(e, ALU_AND, RCX, P_CARRY);
+	_alu(e, ALU_ADD, RCX, RAX);
+	_alu(e, ALU_ADD, RCX, REG_A);
+
+	/* Overflow if ((VALUE ^ RESULT) & (RESULT ^ A) & 0x80) */
+	_mov(e, RDX, RAX);
+	_alu(e, ALU_XOR, RDX, RCX);
+	_mov(e, RSI, RCX);
+	_alu(e, ALU_XOR, RSI, REG_A);
+	_alu(e, ALU_AND, RDX, RSI);
+	_aluImm(e, ALU_AND, RDX, SIGN_BIT);
+	_shift(e, SHIFT_SHR, RDX, 1);
+
+	_aluImm(e, ALU_AND, REG_P, (uint8_t)~(P_CARRY | OVERFLOW_BIT));
+	_alu(e, ALU_OR, REG_P, RDX);
+
+	_mov(e, RDX, RCX);
+	_shift(e, SHIFT_SHR, RDX, 8);
+	_alu(e, ALU_OR, REG_P, RDX);
+
+	_zext8(e, REG_A, RCX);
+	_emitZN(e, REG_A);
+}
+
+/* Compares REG with EAX */
+static void _emitCompare(Emitter *e, const int REG) {
+	_mov(e, RCX, REG);
+	_alu(e, ALU_SUB, RCX, RAX);
+
+	/* Carry is set when there's no borrow */
+	_mov(e, RDX, RCX);
+	_shift(e, SHIFT_SHR, RDX, 31);
+	_aluImm(e, ALU_XOR, RDX, P_CARRY);
+	_aluImm(e, ALU_AND, REG_P, (uint8_t)~P_CARRY);
+	_alu(e, ALU_OR, REG_P, RDX);
+
+	_emitZN(e, RCX);
+}
+
+static void _emitBranch(Emitter *e, const uint8_t FLAG, const bool SET,
+						const uint16_t ARG, const uint16_t NEXT) {
+	const uint16_t TARGET = (uint16_t)(NEXT + (int8_t)ARG);
+	const Cond TAKEN = SET ? CC_NZ : CC_Z;
+
+	_movImm(e, RAX, NEXT);
+	_movImm(e, RCX, TARGET);
+	_testImm8(e, REG_P, FLAG);
+	_cmov(e, TAKEN, RAX, RCX);
+	_storeWord(e, RAX, OFF_PC);
+
+	/* Taking it costs a cycle, or two if it lands on another page. Whether
+	 * it does is known already, so only the taken flag is left to add
+	 */
+	const bool CROSS = ((NEXT ^ TARGET) & 0xFF00) != 0;
+
+	_setcc(e, TAKEN, RDX);
+	_zext8(e, RDX, RDX);
+	if( CROSS ) {
+		_shift(e, SHIFT_SHL, RDX, 1);
+	}
+	_alu(e, ALU_ADD, REG_PENDING, RDX);
+
+	e->penalty = CROSS ? 2 : 1;
+}
+
+typedef enum {
+	JIT_UNSUPPORTED, /* Left to the interpreter, nothing was emitted */
+	JIT_NEXT,
+	JIT_NEXT_IO, /* May have written to I/O */
+	JIT_END,	 /* Sets the PC, ends the block */
+} JitResult;
+
+static JitResult _emitOp(Emitter *e, const uint8_t OPCODE, const uint16_t ARG,
+						 const uint16_t NEXT) {
+	const AddressingMode MODE = OPS[OPCODE].mode;
+
+	switch( OPCODE ) {
+		case 0xA9: /* LDA */
+		case 0xA5:
+		case 0xB5:
+		case 0xAD:
+		case 0xBD:
+		case 0xB9:
+		case 0xA1:
+		case 0xB1:
+			_emitLoad(e, REG_A, MODE, ARG);
+			return JIT_NEXT;
+
+		case 0xA2: /* LDX */
+		case 0xA6:
+		case 0xB6:
+		case 0xAE:
+		case 0xBE:
+			_emitLoad(e, REG_X, MODE, ARG);
+			return JIT_NEXT;
+
+		case 0xA0: /* LDY */
+		case 0xA4:
+		case 0xB4:
+		case 0xAC:
+		case 0xBC:
+			_emitLoad(e, REG_Y, MODE, ARG);
+			return JIT_NEXT;
+
+		case 0x85: /* STA */
+		case 0x95:
+		case 0x8D:
+		case 0x9D:
+		case 0x99:
+		case 0x81:
+		case 0x91:
+			return _emitWrite(e, MODE, ARG, REG_A) ? JIT_NEXT_IO : JIT_NEXT;
+
+		case 0x86: /* STX */
+		case 0x96:
+		case 0x8E:
+			return _emitWrite(e, MODE, ARG, REG_X) ? JIT_NEXT_IO : JIT_NEXT;
+
+		case 0x84: /* STY */
+		case 0x94:
+		case 0x8C:
+			return _emitWrite(e, MODE, ARG, REG_Y) ? JIT_NEXT_IO : JIT_NEXT;
+
+		case 0x69: /* ADC */
+		case 0x65:
+		case 0x75:
+		case 0x6D:
+		case 0x7D:
+		case 0x79:
+		case 0x61:
+		case 0x71:
+			_emitRead(e, MODE, ARG);
+			_emitAdc(e);
+			return JIT_NEXT;
+
+		case 0xE9: /* SBC */
+		case 0xE5:
+		case 0xF5:
+		case 0xED:
+		case 0xFD:
+		case 0xF9:
+		case 0xE1:
+		case 0xF1:
+			_emitRead(e, MODE, ARG);
+			_aluImm(e, ALU_XOR, RAX, 0xFF);
+			_emitAdc(e);
+			return JIT_NEXT;
+
+		case 0x29: /* AND */
+		case 0x25:
+		case 0x35:
+		case 0x2D:
+		case 0x3D:
+		case 0x39:
+		case 0x21:
+		case 0x31:
+			_emitRead(e, MODE, ARG);
+			_alu(e, ALU_AND, REG_A, RAX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x09: /* ORA */
+		case 0x05:
+		case 0x15:
+		case 0x0D:
+		case 0x1D:
+		case 0x19:
+		case 0x01:
+		case 0x11:
+			_emitRead(e, MODE, ARG);
+			_alu(e, ALU_OR, REG_A, RAX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x49: /* EOR */
+		case 0x45:
+		case 0x55:
+		case 0x4D:
+		case 0x5D:
+		case 0x59:
+		case 0x41:
+		case 0x51:
+			_emitRead(e, MODE, ARG);
+			_alu(e, ALU_XOR, REG_A, RAX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0xC9: /* CMP */
+		case 0xC5:
+		case 0xD5:
+		case 0xCD:
+		case 0xDD:
+		case 0xD9:
+		case 0xC1:
+		case 0xD1:
+			_emitRead(e, MODE, ARG);
+			_emitCompare(e, REG_A);
+			return JIT_NEXT;
+
+		case 0xE0: /* CPX */
+		case 0xE4:
+		case 0xEC:
+			_emitRead(e, MODE, ARG);
+			_emitCompare(e, REG_X);
+			return JIT_NEXT;
+
+		case 0xC0: /* CPY */
+		case 0xC4:
+		case 0xCC:
+			_emitRead(e, MODE, ARG);
+			_emitCompare(e, REG_Y);
+			return JIT_NEXT;
+
+		case 0x24: /* BIT */
+		case 0x2C:
+			_emitRead(e, MODE, ARG);
+			_aluImm(e, ALU_AND, REG_P,
+					(uint8_t)~(SIGN_BIT | OVERFLOW_BIT | P_ZERO));
+			_mov(e, RCX, RAX);
+			_aluImm(e, ALU_AND, RCX, SIGN_BIT | OVERFLOW_BIT);
+			_alu(e, ALU_OR, REG_P, RCX);
+			_alu(e, ALU_AND, RAX, REG_A);
+			_testImm8(e, RAX, 0xFF);
+			_setcc(e, CC_Z, RDX);
+			_zext8(e, RDX, RDX);
+			_shift(e, SHIFT_SHL, RDX, 1);
+			_alu(e, ALU_OR, REG_P, RDX);
+			return JIT_NEXT;
+
+		case 0xE6: /* INC */
+		case 0xF6:
+		case 0xEE:
+		case 0xC6: /* DEC */
+		case 0xD6:
+		case 0xCE: {
+			/* Read-modify-write is only compiled for RAM */
+			if( MODE == M_ABSOLUTE && ARG >= 0x2000 ) {
+				return JIT_UNSUPPORTED;
+			}
+
+			uint16_t address = 0;
+			int index = NO_INDEX;
+			int32_t disp = OFF_RAM;
+
+			if( _emitAddress(e, MODE, ARG, &address) == ADDR_RAM ) {
+				index = RCX;
+			} else {
+				disp += address & 0x07FF;
+			}
+
+			const bool INC = (OPCODE & 0x20) != 0;
+
+			_loadByte(e, RAX, index, disp);
+			_lea(e, RAX, RAX, INC ? 1 : -1);
+			_storeByte(e, RAX, index, disp);
+			_emitZN(e, RAX);
+			return JIT_NEXT;
+		}
+
+		case 0xE8: /* INX */
+		case 0xCA: /* DEX */
+			_lea(e, RAX, REG_X, (OPCODE == 0xE8) ? 1 : -1);
+			_zext8(e, REG_X, RAX);
+			_emitZN(e, REG_X);
+			return JIT_NEXT;
+
+		case 0xC8: /* INY */
+		case 0x88: /* DEY */
+			_lea(e, RAX, REG_Y, (OPCODE == 0xC8) ? 1 : -1);
+			_zext8(e, REG_Y, RAX);
+			_emitZN(e, REG_Y);
+			return JIT_NEXT;
+
+		case 0xAA: /* TAX */
+			_mov(e, REG_X, REG_A);
+			_emitZN(e, REG_X);
+			return JIT_NEXT;
+
+		case 0xA8: /* TAY */
+			_mov(e, REG_Y, REG_A);
+			_emitZN(e, REG_Y);
+			return JIT_NEXT;
+
+		case 0x8A: /* TXA */
+			_mov(e, REG_A, REG_X);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x98: /* TYA */
+			_mov(e, REG_A, REG_Y);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0xBA: /* TSX */
+			_loadByte(e, REG_X, NO_INDEX, OFF_STACK);
+			_emitZN(e, REG_X);
+			return JIT_NEXT;
+
+		case 0x9A: /* TXS */
+			_storeByte(e, REG_X, NO_INDEX, OFF_STACK);
+			return JIT_NEXT;
+
+		case 0x18: /* CLC */
+			_aluImm(e, ALU_AND, REG_P, (uint8_t)~P_CARRY);
+			return JIT_NEXT;
+
+		case 0x38: /* SEC */
+			_aluImm(e, ALU_OR, REG_P, P_CARRY);
+			return JIT_NEXT;
+
+		case 0xD8: /* CLD */
+			_aluImm(e, ALU_AND, REG_P, (uint8_t)~P_DECIMAL);
+			return JIT_NEXT;
+
+		case 0xF8: /* SED */
+			_aluImm(e, ALU_OR, REG_P, P_DECIMAL);
+			return JIT_NEXT;
+
+		case 0x78: /* SEI */
+			_aluImm(e, ALU_OR, REG_P, P_INTR);
+			return JIT_NEXT;
+
+		case 0xB8: /* CLV */
+			_aluImm(e, ALU_AND, REG_P, (uint8_t)~OVERFLOW_BIT);
+			return JIT_NEXT;
+
+		case 0xEA: /* NOP */
+			return JIT_NEXT;
+
+		case 0x0A: /* ASL A */
+			_mov(e, RAX, REG_A);
+			_shift(e, SHIFT_SHL, RAX, 1);
+			_emitCarryFromBit(e, RAX, 8);
+			_zext8(e, REG_A, RAX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x4A: /* LSR A */
+			_emitCarryFromBit(e, REG_A, 0);
+			_shift(e, SHIFT_SHR, REG_A, 1);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x2A: /* ROL A */
+			_mov(e, RCX, REG_P);
+			_aluImm(e, ALU_AND, RCX, P_CARRY);
+			_mov(e, RAX, REG_A);
+			_shift(e, SHIFT_SHL, RAX, 1);
+			_alu(e, ALU_OR, RAX, RCX);
+			_emitCarryFromBit(e, RAX, 8);
+			_zext8(e, REG_A, RAX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x6A: /* ROR A */
+			_mov(e, RCX, REG_P);
+			_aluImm(e, ALU_AND, RCX, P_CARRY);
+			_shift(e, SHIFT_SHL, RCX, 7);
+			_emitCarryFromBit(e, REG_A, 0);
+			_shift(e, SHIFT_SHR, REG_A, 1);
+			_alu(e, ALU_OR, REG_A, RCX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		case 0x48: /* PHA */
+			_mov(e, RAX, REG_A);
+			_emitPush(e);
+			return JIT_NEXT;
+
+		case 0x08: /* PHP */
+			_mov(e, RAX, REG_P);
+			_aluImm(e, ALU_OR, RAX, BFLAG1_BIT | BFLAG2_BIT);
+			_emitPush(e);
+			return JIT_NEXT;
+
+		case 0x68: /* PLA */
+			_emitPull(e);
+			_mov(e, REG_A, RAX);
+			_emitZN(e, REG_A);
+			return JIT_NEXT;
+
+		/* Ends the block, so an IRQ it unmasks is taken before the next
+		 * instruction. CLI is left to the interpreter for the same reason
+		 */
+		case 0x28: /* PLP */
+			_emitPull(e);
+			_aluImm(e, ALU_OR, RAX, BFLAG2_BIT);
+			_aluImm(e, ALU_AND, RAX, (uint8_t)~BFLAG1_BIT);
+			_mov(e, REG_P, RAX);
+			_movImm(e, RAX, NEXT);
+			_storeWord(e, RAX, OFF_PC);
+			return JIT_END;
+
+		case 0x10: /* BPL */
+			_emitBranch(e, SIGN_BIT, false, ARG, NEXT);
+			return JIT_END;
+		case 0x30: /* BMI */
+			_emitBranch(e, SIGN_BIT, true, ARG, NEXT);
+			return JIT_END;
+		case 0x50: /* BVC */
+			_emitBranch(e, OVERFLOW_BIT, false, ARG, NEXT);
+			return JIT_END;
+		case 0x70: /* BVS */
+			_emitBranch(e, OVERFLOW_BIT, true, ARG, NEXT);
+			return JIT_END;
+		case 0x90: /* BCC */
+			_emitBranch(e, P_CARRY, false, ARG, NEXT);
+			return JIT_END;
+		case 0xB0: /* BCS */
+			_emitBranch(e, P_CARRY, true, ARG, NEXT);
+			return JIT_END;
+		case 0xD0: /* BNE */
+			_emitBranch(e, P_ZERO, false, ARG, NEXT);
+			return JIT_END;
+		case 0xF0: /* BEQ */
+			_emitBranch(e, P_ZERO, true, ARG, NEXT);
+			return JIT_END;
+
+		case 0x4C: /* JMP */
+			_movImm(e, RAX, ARG);
+			_storeWord(e, RAX, OFF_PC);
+			return JIT_END;
+
+		case 0x20: { /* JSR */
+			const uint16_t RETURN = (uint16_t)(NEXT - 1);
+
+			_movImm(e, RAX, RETURN >> 8);
+			_emitPush(e);
+			_movImm(e, RAX, RETURN & 0xFF);
+			_emitPush(e);
+
+			_movImm(e, RAX, ARG);
+			_storeWord(e, RAX, OFF_PC);
+			return JIT_END;
+		}
+
+		case 0x60: /* RTS */
+			_emitPull(e);
+			_mov(e, RSI, RAX);
+			_emitPull(e);
+			_shift(e, SHIFT_SHL, RAX, 8);
+			_alu(e, ALU_OR, RAX, RSI);
+			_lea(e, RAX, RAX, 1);
+			_storeWord(e, RAX, OFF_PC);
+			return JIT_END;
+
+		default:
+			return JIT_UNSUPPORTED;
+	}
+}
+
+/* - - - Block cache - - - */
+
+/* Throws away every compiled block once the code buffer runs out */
+static void _flush(Jit *jit) {
+	jit->used = 0;
+	memset(jit->blocks, 0, sizeof(jit->blocks));
+}
+
+static void _compile(Jit *jit, CPU *cpu, JitBlock *block, const uint16_t START,
+					 const uint32_t STAMP) {
+	if( JIT_CODE_SIZE - jit->used < JIT_BLOCK_CODE_MAX ) {
+		_flush(jit);
+	}
+
+	Emitter e = {jit->code + jit->used, 0};
+	uint8_t *const ENTRY = e.p;
+
+	_emitPrologue(&e);
+
+	/* Blocks never leave the PRG window they started in, so a single stamp
+	 * is enough to tell when they go stale
+	 */
+	const uint8_t WINDOW = (uint8_t)((START - JIT_BASE) / BUS_PRG_WINDOW_SIZE);
+	const uint32_t WINDOW_END =
+		(uint32_t)(START - START % BUS_PRG_WINDOW_SIZE) + BUS_PRG_WINDOW_SIZE;
+
+	uint32_t pc = START;
+	uint8_t ops = 0;
+	uint8_t cycles = 0;
+	JitResult result = JIT_NEXT;
+
+	while( ops < JIT_BLOCK_OPS_MAX ) {
+		const uint8_t OPCODE = busRead(&cpu->bus, (uint16_t)pc);
+		const JitOpInfo *INFO = &OPS[OPCODE];
+
+		if( INFO->bytes == 0 || pc + INFO->bytes > WINDOW_END ||
+			cycles + INFO->cycles + JIT_PENALTY_MAX > JIT_BLOCK_CYCLES_MAX ) {
+			break;
+		}
+
+		uint16_t arg = 0;
+		switch( INFO->bytes ) {
+			case 2:
+				arg = busRead(&cpu->bus, (uint16_t)(pc + 1));
+				break;
+			case 3:
+				arg = busRead16(&cpu->bus, (uint16_t)(pc + 1));
+				break;
+		}
+
+		const uint16_t NEXT = (uint16_t)(pc + INFO->bytes);
+
+		e.penalty = 0;
+		result = _emitOp(&e, OPCODE, arg, NEXT);
+		if( result == JIT_UNSUPPORTED ) {
+			break;
+		}
+
+		_aluImm(&e, ALU_ADD, REG_PENDING, INFO->cycles);
+
+		if( result == JIT_NEXT_IO ) {
+			_emitIOCheck(&e, NEXT, WINDOW, STAMP);
+		}
+
+		++ops;
+		cycles = (uint8_t)(cycles + INFO->cycles + e.penalty);
+		pc = NEXT;
+
+		if( result == JIT_END ) {
+			break;
+		}
+	}
+
+	block->stamp = STAMP;
+	block->cycles = cycles;
+	block->idle = cpuIsIdleLoop(cpu, START);
+
+	if( ops == 0 ) {
+		block->fn = NULL;
+		return;
+	}
+
+	if( result == JIT_END ) {
+		_emitExit(&e);
+	} else {
+		_emitExitTo(&e, (uint16_t)pc);
+	}
+
+	block->fn = (JitBlockFn)(uintptr_t)ENTRY;
+	jit->used += (size_t)(e.p - ENTRY);
+}
+
+Jit *jitCreate(void) {
+	Jit *jit = calloc(1, sizeof(Jit));
+	if( jit == NULL ) {
+		errPrint(C_RED, "Not enough memory for the JIT");
+		exit(71);
+	}
+
+#ifdef _WIN32
+	jit->code = VirtualAlloc(NULL, JIT_CODE_SIZE, MEM_COMMIT | MEM_RESERVE,
+							 PAGE_EXECUTE_READWRITE);
+	if( jit->code == NULL ) {
+#else
+	jit->code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+					 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if( jit->code == MAP_FAILED ) {
+#endif
+		errPrint(C_RED, "Couldn't map executable memory for the JIT");
+		exit(71);
+	}
+
+	return jit;
+}
+
+void jitDestroy(Jit *jit) {
+	if( jit == NULL ) {
+		return;
+	}
+
+#ifdef _WIN32
+	VirtualFree(jit->code, 0, MEM_RELEASE);
+#else
+	munmap(jit->code, JIT_CODE_SIZE);
+#endif
+
+	free(jit);
+}
+
+bool jitRun(CPU *cpu) {
+	Jit *jit = cpu->jit;
+	const uint16_t PC = cpu->pc;
+
+	/* Compiled code goes straight to RAM, so watches need the interpreter */
+	if( jit == NULL || cpu->watches != NULL || PC < JIT_BASE ) {
+		return false;
+	}
+
+	const uint16_t OFFSET = PC - JIT_BASE;
+	const uint32_t STAMP = cpu->bus.prgStamps[OFFSET / BUS_PRG_WINDOW_SIZE];
+
+	JitBlock *block = &jit->blocks[OFFSET];
+	if( block->stamp != STAMP ) {
+		_compile(jit, cpu, block, PC, STAMP);
+	}
+
+	if( block->fn == NULL ) {
+		return false;
+	}
+
+	/* Cycles only reach the bus on I/O and at the end of a block, so blocks
+	 * that might run across a scheduled event are left to the interpreter
+	 */
+	if( cpu->bus.cycles + block->cycles >= cpu->bus.sched.next ) {
+		return false;
+	}
+
+	if( cpu->trace != NULL ) {
+		cpuTraceRecord(cpu);
+	}
+
+	block->fn(cpu);
+
+	/* P lives in a register inside blocks, so the bus only hears about an
+	 * SEI or PLP once the block has written it back
+	 */
+	busMaskIRQ(&cpu->bus, cpu->status.interrupt);
+
+	if( block->idle && cpu->pc == PC ) {
+		cpuSkipIdleLoop(cpu, 0);
+	}
+
+	return true;
+}
@@ -1,21 +1,254 @@
 #include "frame.h"
 
-#include <stdio.h>
 #include <string.h>
 
-#include "ppu.h"
+#if defined(__x86_64__) || defined(__i386__)
+#define FRAME_X86
+#include <immintrin.h>
+#endif
 
 void frameInit(Frame *frame) {
-	memset(frame->data, 0, FRAME_SIZE);
+	memset(frame->pixels, 0, FRAME_SIZE);
+	memset(frame->emphasis, 0, SCR_H);
 }
 
-void frameSetPixel(Frame *frame, const size_t X, const size_t Y,
-				   SDL_Color color) {
-	const size_t BASE = Y * 3 * SCR_W + X * 3;
+static uint8_t _dim(uint8_t value, const uint8_t TIMES) {
+	for( uint8_t i = 0; i < TIMES; ++i ) {
+		value = (uint8_t)(value * 3 / 4);
+	}
+
+	return value;
+}
+
+/* Each emphasised channel dims the other two by a quarter */
+static SDL_Color _emphasize(SDL_Color color, const uint8_t EMPHASIS) {
+	const uint8_t R = EMPHASIS & 1;
+	const uint8_t G = (EMPHASIS >> 1) & 1;
+	const uint8_t B = (EMPHASIS >> 2) & 1;
+
+	color.r = _dim(color.r, (uint8_t)(G + B));
+	color.g = _dim(color.g, (uint8_t)(R + B));
+	color.b = _dim(color.b, (uint8_t)(R + G));
+
+	return color;
+}
+
+void frameLUTInitARGB(FrameLUT *lut) {
+	for( uint8_t e = 0; e < FRAME_EMPHASES; ++e ) {
+		for( uint8_t c = 0; c < FRAME_COLORS; ++c ) {
+			const SDL_Color RGB = _emphasize(SYS_PAL[c], e);
+
+			lut->colors[e][c] = 0xFF000000u | (uint32_t)RGB.r << 16 |
+								(uint32_t)RGB.g << 8 | RGB.b;
+		}
+	}
+}
+
+void frameLUTInitGray(FrameLUT *lut) {
+	for( uint8_t e = 0; e < FRAME_EMPHASES; ++e ) {
+		for( uint8_t c = 0; c < FRAME_COLORS; ++c ) {
+			const SDL_Color RGB = _emphasize(SYS_PAL[c], e);
+
+			/* BT.601 weights, out of 256 */
+			lut->colors[e][c] = (77u * RGB.r + 150u * RGB.g + 29u * RGB.b) >> 8;
+		}
+	}
+}
+
+static void _line32Scalar(const uint8_t *PIXELS, const uint32_t *COLORS,
+						  uint32_t *out) {
+	for( size_t x = 0; x < SCR_W; ++x ) {
+		out[x] = COLORS[PIXELS[x] & 0x3F];
+	}
+}
+
+static void _line8Scalar(const uint8_t *PIXELS, const uint32_t *COLORS,
+						 uint8_t *out) {
+	for( size_t x = 0; x < SCR_W; ++x ) {
+		out[x] = (uint8_t)COLORS[PIXELS[x] & 0x3F];
+	}
+}
+
+#ifdef FRAME_X86
+
+/* The low bytes of COLORS as four 16 byte shuffle tables. Entries fit in a
+ * byte for 8 bit output, so the saturating packs leave them alone
+ */
+__attribute__((target("ssse3"))) static inline void
+_bytesSSSE3(const uint32_t *COLORS, __m128i tables[4]) {
+	const __m128i LOW = _mm_set1_epi32(0xFF);
+
+	for( uint8_t t = 0; t < 4; ++t ) {
+		const __m128i *ROW = (const __m128i *)&COLORS[t * 16];
+
+		const __m128i A = _mm_and_si128(_mm_loadu_si128(ROW), LOW);
+		const __m128i B = _mm_and_si128(_mm_loadu_si128(ROW + 1), LOW);
+		const __m128i C = _mm_and_si128(_mm_loadu_si128(ROW + 2), LOW);
+		const __m128i D = _mm_and_si128(_mm_loadu_si128(ROW + 3), LOW);
+
+		tables[t] = _mm_packus_epi16(_mm_packs_epi32(A, B), _mm_packs_epi32(C, D));
+	}
+}
+
+/* PSHUFB only looks at the low 4 bits of an index (and zeroes on bit 7), so
+ * each table is looked up with the low nibble and kept where the colour's
+ * top two bits pick it
+ */
+__attribute__((target("ssse3"))) static void
+_line8SSSE3(const uint8_t *PIXELS, const uint32_t *COLORS, uint8_t *out) {
+	__m128i tables[4];
+	_bytesSSSE3(COLORS, tables);
+
+	const __m128i NIBBLE = _mm_set1_epi8(0x0F);
+	const __m128i HIGH = _mm_set1_epi8(0x30);
+
+	for( size_t x = 0; x < SCR_W; x += 16 ) {
+		const __m128i INDEX = _mm_loadu_si128((const __m128i *)&PIXELS[x]);
+		const __m128i LOW = _mm_and_si128(INDEX, NIBBLE);
+		const __m128i TABLE = _mm_and_si128(INDEX, HIGH);
+
+		__m128i result = _mm_setzero_si128();
+		for( uint8_t t = 0; t < 4; ++t ) {
+			const __m128i PICK =
+				_mm_cmpeq_epi8(TABLE, _mm_set1_epi8((char)(t << 4)));
+			result = _mm_or_si128(
+				result, _mm_and_si128(PICK, _mm_shuffle_epi8(tables[t], LOW)));
+		}
+
+		_mm_storeu_si128((__m128i *)&out[x], result);
+	}
+}
+
+/* Same as the SSSE3 one, 32 pixels at a time. The shuffle stays within 128
+ * bit lanes, so both lanes get a copy of each table
+ */
+__attribute__((target("avx2"))) static void
+_line8AVX2(const uint8_t *PIXELS, const uint32_t *COLORS, uint8_t *out) {
+	__m128i bytes[4];
+	_bytesSSSE3(COLORS, bytes);
+
+	__m256i tables[4];
+	for( uint8_t t = 0; t < 4; ++t ) {
+		tables[t] = _mm256_broadcastsi128_si256(bytes[t]);
+	}
+
+	const __m256i NIBBLE = _mm256_set1_epi8(0x0F);
+	const __m256i HIGH = _mm256_set1_epi8(0x30);
+
+	for( size_t x = 0; x < SCR_W; x += 32 ) {
+		const __m256i INDEX = _mm256_loadu_si256((const __m256i *)&PIXELS[x]);
+		const __m256i LOW = _mm256_and_si256(INDEX, NIBBLE);
+		const __m256i TABLE = _mm256_and_si256(INDEX, HIGH);
+
+		__m256i result = _mm256_setzero_si256();
+		for( uint8_t t = 0; t < 4; ++t ) {
+			const __m256i PICK =
+				_mm256_cmpeq_epi8(TABLE, _mm256_set1_epi8((char)(t << 4)));
+			result = _mm256_or_si256(
+				result,
+				_mm256_and_si256(PICK, _mm256_shuffle_epi8(tables[t], LOW)));
+		}
+
+		_mm256_storeu_si256((__m256i *)&out[x], result);
+	}
+}
+
+/* Widens 8 indices to 32 bits and gathers their entries */
+__attribute__((target("avx2"))) static void
+_line32AVX2(const uint8_t *PIXELS, const uint32_t *COLORS, uint32_t *out) {
+	const __m256i MASK = _mm256_set1_epi32(0x3F);
+
+	for( size_t x = 0; x < SCR_W; x += 8 ) {
+		const __m128i BYTES = _mm_loadl_epi64((const __m128i *)&PIXELS[x]);
+		const __m256i INDEX =
+			_mm256_and_si256(_mm256_cvtepu8_epi32(BYTES), MASK);
+
+		_mm256_storeu_si256((__m256i *)&out[x],
+							_mm256_i32gather_epi32((const int *)COLORS, INDEX, 4));
+	}
+}
+
+#endif
+
+FrameLine32Fn frameKernel32(const FrameKernel KERNEL) {
+#ifdef FRAME_X86
+	__builtin_cpu_init();
+#endif
+
+	switch( KERNEL ) {
+		case FRAME_SCALAR:
+			return _line32Scalar;
+
+#ifdef FRAME_X86
+		case FRAME_AVX2:
+			return __builtin_cpu_supports("avx2") ? _line32AVX2 : NULL;
+#endif
+
+		default:
+			return NULL;
+	}
+}
+
+FrameLine8Fn frameKernel8(const FrameKernel KERNEL) {
+#ifdef FRAME_X86
+	__builtin_cpu_init();
+#endif
+
+	switch( KERNEL ) {
+		case FRAME_SCALAR:
+			return _line8Scalar;
+
+#ifdef FRAME_X86
+		case FRAME_SSSE3:
+			return __builtin_cpu_supports("ssse3") ? _line8SSSE3 : NULL;
+
+		case FRAME_AVX2:
+			return __builtin_cpu_supports("avx2") ? _line8AVX2 : NULL;
+#endif
+
+		default:
+			return NULL;
+	}
+}
+
+const char *frameKernelName(const FrameKernel KERNEL) {
+	static const char *NAMES[FRAME_KERNELS] = {"scalar", "SSSE3", "AVX2"};
+	return NAMES[KERNEL];
+}
+
+static FrameLine32Fn gLine32 = NULL;
+static FrameLine8Fn gLine8 = NULL;
+
+/* Picks the fastest kernels there are, the first time a frame's converted */
+static void _pickKernels(void) {
+	for( int kernel = FRAME_KERNELS - 1; kernel >= FRAME_SCALAR; --kernel ) {
+		if( gLine32 == NULL ) {
+			gLine32 = frameKernel32((FrameKernel)kernel);
+		}
+		if( gLine8 == NULL ) {
+			gLine8 = frameKernel8((FrameKernel)kernel);
+		}
+	}
+}
+
+void frameConvert32(const Frame *FRAME, const FrameLUT *LUT, uint32_t *out) {
+	if( UNLIKELY(gLine32 == NULL) ) {
+		_pickKernels();
+	}
+
+	for( size_t y = 0; y < SCR_H; ++y ) {
+		gLine32(&FRAME->pixels[y * SCR_W], LUT->colors[FRAME->emphasis[y] & 7],
+				&out[y * SCR_W]);
+	}
+}
+
+void frameConvert8(const Frame *FRAME, const FrameLUT *LUT, uint8_t *out) {
+	if( UNLIKELY(gLine8 == NULL) ) {
+		_pickKernels();
+	}
 
-	if( (BASE + 2) < FRAME_SIZE ) {
-		frame->data[BASE] = color.r;
-		frame->data[BASE + 1] = color.g;
-		frame->data[BASE + 2] = color.b;
+	for( size_t y = 0; y < SCR_H; ++y ) {
+		gLine8(&FRAME->pixels[y * SCR_W], LUT->colors[FRAME->emphasis[y] & 7],
+			   &out[y * SCR_W]);
 	}
 }
@@ -16,17 +16,20 @@ void joyWrite(Joypad *joy, const uint8_t VALUE) {
 }
 
 uint8_t joyRead(Joypad *joy) {
-	if( joy->pointer > 7 ) {
-		return 0x40;
+	const uint8_t RESULT = joyPeek(joy);
+
+	if( !joy->strobe && joy->pointer <= 7 ) {
+		++joy->pointer;
 	}
 
-	uint8_t controller = joy->data.bits & (uint8_t)(1 << joy->pointer);
-	controller >>= joy->pointer;
-	controller |= 0x40;
+	return RESULT;
+}
 
-	if( !joy->strobe ) {
-		++joy->pointer;
+uint8_t joyPeek(const Joypad *joy) {
+	/* Once all 8 buttons are shifted out, a standard controller reads 1 */
+	if( joy->pointer > 7 ) {
+		return 0x41;
 	}
 
-	return controller;
+	return (uint8_t)(((joy->data.bits >> joy->pointer) & 1) | 0x40);
 }
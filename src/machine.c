@@ -0,0 +1,55 @@
+#include "machine.h"
+
+#include <stdlib.h>
+
+#include "error.h"
+#include "watch.h"
+
+struct _Machine {
+	CPU cpu;
+	ROM rom;
+};
+
+Machine *machineCreate(const ROM *CART) {
+	Machine *machine = calloc(1, sizeof(Machine));
+	if( machine == NULL ) {
+		errPrint(C_RED, "Not enough memory for a machine");
+		exit(71);
+	}
+
+	machine->rom = *CART;
+	cpuInitFromROM(&machine->cpu, &machine->rom);
+
+	return machine;
+}
+
+void machineDestroy(Machine *machine) {
+	if( machine == NULL ) {
+		return;
+	}
+
+	watchClear(&machine->cpu);
+	cpuTraceDisable(&machine->cpu);
+
+	free(machine);
+}
+
+void machineReset(Machine *machine) {
+	CPU *cpu = &machine->cpu;
+
+	WatchList *watches = cpu->watches;
+	Trace *trace = cpu->trace;
+
+	cpuInitFromROM(cpu, &machine->rom);
+
+	cpu->watches = watches;
+	cpu->trace = trace;
+}
+
+CPU *machineCPU(Machine *machine) {
+	return &machine->cpu;
+}
+
+void machineRun(Machine *machine) {
+	cpuRun(&machine->cpu);
+}
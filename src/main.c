@@ -1,7 +1,11 @@
+#include <string.h>
+
 #include "SDL2/SDL.h"
+#include "bench.h"
 #include "common.h"
 #include "cpu.h"
 #include "error.h"
+#include "machine.h"
 #include "rom.h"
 #include "screen.h"
 #include "test.h"
@@ -17,12 +21,22 @@ int main(int argc, char *argv[]) {
 
 	screenInit(&gScreen);
 
+	if( argc == 2 && strcmp(argv[1], "--bench") == 0 ) {
+		benchRun();
+		screenFree(&gScreen);
+
+		return 0;
+	}
+
 	if( argc == 2 ) {
-		ROM rom; /* TODO: move into fn */
+		ROM rom;
 		romCreateFromFile(&rom, argv[1]);
-		CPU cpu;
-		cpuInitFromROM(&cpu, rom);
-		cpuRun(&cpu);
+
+		Machine *machine = machineCreate(&rom);
+		cpuTraceEnable(machineCPU(machine));
+		machineRun(machine);
+		machineDestroy(machine);
+		romFree(&rom);
 
 		return 0;
 	}
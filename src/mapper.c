@@ -0,0 +1,328 @@
+#include "mapper.h"
+
+#include <string.h>
+
+#include "bus.h"
+
+#define PRG_BANK_SIZE BUS_PRG_WINDOW_SIZE
+#define PAGES_PER_PRG_BANK (PRG_BANK_SIZE / BUS_PAGE_SIZE)
+
+#define NROM 0
+#define MMC1 1
+#define UXROM 2
+#define CNROM 3
+#define MMC3 4
+
+bool mapperIsSupported(const uint8_t ID) {
+	switch( ID ) {
+		case NROM:
+		case MMC1:
+		case UXROM:
+		case CNROM:
+		case MMC3:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/* Banking primitives
+ *
+ * Bank numbers are in units of the bank size and wrap around the cartridge,
+ * like they do on boards with fewer address lines than the register has bits.
+ * Negative PRG banks count back from the last one
+ */
+
+static size_t _prgBanks(Bus *bus) {
+	return bus->rom.prgSize / PRG_BANK_SIZE;
+}
+
+/* Points an 8KB window of $8000-$FFFF at an 8KB PRG bank */
+static void _mapPrg8K(Bus *bus, const uint8_t WINDOW, const int BANK) {
+	const size_t COUNT = _prgBanks(bus);
+	const size_t INDEX = (size_t)((BANK % (int)COUNT) + (int)COUNT) % COUNT;
+
+	uint8_t *host = &bus->rom.prgRom[INDEX * PRG_BANK_SIZE];
+	BusPage *pages = &bus->pages[0x80 + WINDOW * PAGES_PER_PRG_BANK];
+
+	/* Most games rewrite the bank they already have, which shouldn't throw
+	 * away what was decoded from it
+	 */
+	if( pages[0].read == host ) {
+		return;
+	}
+
+	for( uint8_t i = 0; i < PAGES_PER_PRG_BANK; ++i ) {
+		pages[i].read = host + i * BUS_PAGE_SIZE;
+	}
+
+	busInvalidatePrgWindow(bus, WINDOW);
+}
+
+static void _mapPrg16K(Bus *bus, const uint8_t WINDOW, const int BANK) {
+	_mapPrg8K(bus, WINDOW, BANK * 2);
+	_mapPrg8K(bus, WINDOW + 1, BANK * 2 + 1);
+}
+
+static void _mapPrg32K(Bus *bus, const int BANK) {
+	_mapPrg16K(bus, 0, BANK * 2);
+	_mapPrg16K(bus, 2, BANK * 2 + 1);
+}
+
+/* Points a 1KB slot of $0000-$1FFF at a 1KB CHR bank */
+static void _mapChr1K(Bus *bus, const uint8_t SLOT, const size_t BANK) {
+	const size_t COUNT = bus->rom.chrSize / PPU_CHR_BANK_SIZE;
+	ppuMapChr(&bus->ppu, SLOT,
+			  &bus->rom.chrRom[(BANK % COUNT) * PPU_CHR_BANK_SIZE]);
+}
+
+static void _mapChr(Bus *bus, const uint8_t SLOT, const uint8_t SLOTS,
+					const size_t BANK) {
+	for( uint8_t i = 0; i < SLOTS; ++i ) {
+		_mapChr1K(bus, SLOT + i, BANK * SLOTS + i);
+	}
+}
+
+/* MMC1 (mapper 1) */
+
+static void _updateMMC1(Bus *bus) {
+	const Mapper *MAPPER = &bus->mapper;
+
+	const uint8_t CONTROL = MAPPER->regs[0];
+	const uint8_t PRG = MAPPER->regs[3] & 0x0F;
+
+	static const Mirroring MIRRORING[4] = {
+		SINGLE_SCREEN_LOWER,
+		SINGLE_SCREEN_UPPER,
+		VERTICAL,
+		HORIZONTAL,
+	};
+	bus->ppu.mirroring = MIRRORING[CONTROL & 3];
+
+	switch( (CONTROL >> 2) & 3 ) {
+		case 0:
+		case 1:
+			_mapPrg32K(bus, PRG >> 1);
+			break;
+
+		case 2: /* First bank fixed at $8000 */
+			_mapPrg16K(bus, 0, 0);
+			_mapPrg16K(bus, 2, PRG);
+			break;
+
+		case 3: /* Last bank fixed at $C000 */
+			_mapPrg16K(bus, 0, PRG);
+			_mapPrg16K(bus, 2, -1);
+			break;
+	}
+
+	if( (CONTROL & 0x10) != 0 ) {
+		_mapChr(bus, 0, 4, MAPPER->regs[1]);
+		_mapChr(bus, 4, 4, MAPPER->regs[2]);
+	} else {
+		_mapChr(bus, 0, 8, MAPPER->regs[1] >> 1);
+	}
+}
+
+/* Registers are loaded a bit at a time, and the fifth write picks which one
+ * from its address
+ */
+static void _writeMMC1(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	Mapper *mapper = &bus->mapper;
+
+	busSyncPPU(bus);
+
+	if( (VALUE & 0x80) != 0 ) {
+		mapper->shift = 0;
+		mapper->shiftCount = 0;
+		mapper->regs[0] |= 0x0C;
+
+		_updateMMC1(bus);
+		return;
+	}
+
+	mapper->shift |= (uint8_t)((VALUE & 1) << mapper->shiftCount);
+	if( ++mapper->shiftCount < 5 ) {
+		return;
+	}
+
+	mapper->regs[(ADDRESS >> 13) & 3] = mapper->shift;
+	mapper->shift = 0;
+	mapper->shiftCount = 0;
+
+	_updateMMC1(bus);
+}
+
+/* UxROM (mapper 2): switchable $8000, last bank fixed at $C000 */
+
+static void _writeUxROM(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	UNUSED(ADDRESS);
+
+	_mapPrg16K(bus, 0, VALUE);
+}
+
+/* CNROM (mapper 3): one switchable 8KB CHR bank */
+
+static void _writeCNROM(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	UNUSED(ADDRESS);
+
+	busSyncPPU(bus);
+	_mapChr(bus, 0, 8, VALUE);
+}
+
+/* MMC3 (mapper 4) */
+
+static void _updateMMC3(Bus *bus) {
+	const Mapper *MAPPER = &bus->mapper;
+	const uint8_t *R = MAPPER->banks;
+
+	/* $8000 and $C000 swap between R6 and the second to last bank */
+	const bool PRG_SWAP = (MAPPER->bankSelect & 0x40) != 0;
+
+	_mapPrg8K(bus, PRG_SWAP ? 2 : 0, R[6]);
+	_mapPrg8K(bus, 1, R[7]);
+	_mapPrg8K(bus, PRG_SWAP ? 0 : 2, -2);
+	_mapPrg8K(bus, 3, -1);
+
+	/* The 2KB banks (R0, R1) and the 1KB ones (R2-R5) swap pattern tables */
+	const uint8_t CHR_2K = (MAPPER->bankSelect & 0x80) ? 4 : 0;
+	const uint8_t CHR_1K = CHR_2K ^ 4;
+
+	_mapChr(bus, CHR_2K, 2, R[0] >> 1);
+	_mapChr(bus, CHR_2K + 2, 2, R[1] >> 1);
+
+	for( uint8_t i = 0; i < 4; ++i ) {
+		_mapChr1K(bus, CHR_1K + i, R[2 + i]);
+	}
+}
+
+static void _writeMMC3(Bus *bus, const uint16_t ADDRESS, const uint8_t VALUE) {
+	Mapper *mapper = &bus->mapper;
+	const bool ODD = (ADDRESS & 1) != 0;
+
+	busSyncPPU(bus);
+
+	switch( ADDRESS & 0xE000 ) {
+		case 0x8000:
+			if( ODD ) {
+				mapper->banks[mapper->bankSelect & 7] = VALUE;
+			} else {
+				mapper->bankSelect = VALUE;
+			}
+
+			_updateMMC3(bus);
+			return;
+
+		case 0xA000:
+			/* PRG RAM protect on odd addresses isn't emulated */
+			if( !ODD && bus->rom.mirroring != FOUR_SCREEN ) {
+				bus->ppu.mirroring = (VALUE & 1) ? HORIZONTAL : VERTICAL;
+			}
+			return;
+
+		case 0xC000:
+			if( ODD ) {
+				mapper->irqCounter = 0;
+				mapper->irqReload = true;
+			} else {
+				mapper->irqLatch = VALUE;
+			}
+			return;
+
+		default: /* $E000: disabling also acknowledges a pending IRQ */
+			mapper->irqEnabled = ODD;
+
+			if( !ODD ) {
+				busReleaseIRQ(bus, IRQ_MAPPER);
+			}
+			return;
+	}
+}
+
+void mapperScanline(Bus *bus) {
+	Mapper *mapper = &bus->mapper;
+	PPU *ppu = &bus->ppu;
+
+	if( !mapper->countsScanlines || (!ppu->mask.showBG && !ppu->mask.showSpr) ) {
+		return;
+	}
+
+	/* A12 only rises if one of the pattern tables being fetched is at $1000.
+	 * With the background there, it rises a bit later in the line, which is
+	 * close enough
+	 */
+	if( controlBGPatternAddr(&ppu->control) == 0 &&
+		controlSprPatternAddr(&ppu->control) == 0 &&
+		controlSprSize(&ppu->control) == 8 ) {
+		return;
+	}
+
+	if( mapper->irqCounter == 0 || mapper->irqReload ) {
+		mapper->irqCounter = mapper->irqLatch;
+		mapper->irqReload = false;
+	} else {
+		--mapper->irqCounter;
+	}
+
+	if( mapper->irqCounter == 0 && mapper->irqEnabled ) {
+		busAssertIRQ(bus, IRQ_MAPPER);
+	}
+}
+
+void mapperInit(Bus *bus) {
+	Mapper *mapper = &bus->mapper;
+	BusWriteFn writeFn = NULL;
+
+	*mapper = (Mapper){.id = bus->rom.mapper};
+
+	bus->ppu.chrWritable = bus->rom.chrRam;
+	_mapChr(bus, 0, 8, 0);
+
+	if( bus->rom.prgSize == 0 ) {
+		return;
+	}
+
+	switch( mapper->id ) {
+		case MMC1:
+			mapper->regs[0] = 0x0C;
+			_updateMMC1(bus);
+
+			writeFn = _writeMMC1;
+			break;
+
+		case UXROM:
+			_mapPrg16K(bus, 0, 0);
+			_mapPrg16K(bus, 2, -1);
+
+			writeFn = _writeUxROM;
+			break;
+
+		case CNROM:
+			_mapPrg32K(bus, 0);
+
+			writeFn = _writeCNROM;
+			break;
+
+		case MMC3: {
+			static const uint8_t BANKS[8] = {0, 2, 4, 5, 6, 7, 0, 1};
+			memcpy(mapper->banks, BANKS, sizeof(BANKS));
+			mapper->countsScanlines = true;
+			_updateMMC3(bus);
+
+			writeFn = _writeMMC3;
+		} break;
+
+		default: /* NROM: 16KB of PRG ROM shows up twice, and no registers */
+			_mapPrg32K(bus, 0);
+			break;
+	}
+
+	if( writeFn == NULL ) {
+		return;
+	}
+
+	for( uint16_t page = 0x80; page < BUS_PAGES; ++page ) {
+		bus->pages[page].writeFn = writeFn;
+	}
+}
@@ -5,9 +5,10 @@
 #include <string.h>
 
 #include "error.h"
-#include "rect.h"
+#include "ppu_tile.h"
+#include "screen.h"
 
-static uint16_t _mirrorVramAddress(PPU *ppu, const uint16_t ADDRESS) {
+static uint16_t _mirrorVramAddress(const PPU *ppu, const uint16_t ADDRESS) {
 	const uint16_t MIRRORED = (ADDRESS & 0x2FFF);
 	const uint16_t INDEX = (MIRRORED - 0x2000);
 	const uint16_t NAMETABLE = (INDEX / 0x0400);
@@ -22,13 +23,36 @@ static uint16_t _mirrorVramAddress(PPU *ppu, const uint16_t ADDRESS) {
 		} else if( NAMETABLE == 3 ) {
 			return INDEX - 0x0800;
 		}
+	} else if( ppu->mirroring == SINGLE_SCREEN_LOWER ) {
+		return INDEX & 0x03FF;
+	} else if( ppu->mirroring == SINGLE_SCREEN_UPPER ) {
+		return (INDEX & 0x03FF) + 0x0400;
 	}
 
 	return INDEX;
 }
 
+/* $3F10, $3F14, $3F18 and $3F1C are the same bytes as $3F00, $3F04, ... */
+static uint8_t _paletteIndex(const uint16_t ADDRESS) {
+	const uint8_t INDEX = ADDRESS & 0x1F;
+	return ((INDEX & 0x13) == 0x10) ? INDEX & 0x0F : INDEX;
+}
+
+/* CHR starts out as the first 8KB of chrRom, read-only */
 void ppuInit(PPU *ppu, uint8_t *chrRom, const Mirroring MIRRORING) {
-	ppu->chrRom = chrRom;
+	for( uint8_t i = 0; i < PPU_CHR_BANKS; ++i ) {
+		ppu->chrBanks[i] = chrRom + i * PPU_CHR_BANK_SIZE;
+	}
+
+	memset(ppu->tileValid, 0, sizeof(ppu->tileValid));
+	memset(ppu->chrChanged, 0, sizeof(ppu->chrChanged));
+	ppu->chrChangedAny = false;
+
+	memset(ppu->bgDirty, true, sizeof(ppu->bgDirty));
+	ppu->bgDirtyAny = true;
+	ppu->bgPlaneTiles = 0;
+
+	ppu->chrWritable = false;
 	ppu->mirroring = MIRRORING;
 
 	memset(ppu->palTable, 0, 32);
@@ -43,22 +67,87 @@ void ppuInit(PPU *ppu, uint8_t *chrRom, const Mirroring MIRRORING) {
 	scrollInit(&ppu->scroll);
 	addrInit(&ppu->addr);
 
+	ppu->scanline = 0;
 	ppu->cycles = 0;
+	ppu->frameScrollY = 0;
 	ppu->nmiInterrupt = false;
 
 	frameInit(&ppu->frame);
 }
 
-void ppuInitEmpty(PPU *ppu) {
-	uint8_t CHR_ROM[256] = {0};
+static uint8_t EMPTY_CHR[PPU_CHR_BANKS * PPU_CHR_BANK_SIZE];
 
-	ppuInit(ppu, CHR_ROM, HORIZONTAL);
+void ppuInitEmpty(PPU *ppu) {
+	ppuInit(ppu, EMPTY_CHR, HORIZONTAL);
 }
 
 void ppuInitEmptyVertical(PPU *ppu) {
-	uint8_t CHR_ROM[256] = {0};
+	ppuInit(ppu, EMPTY_CHR, VERTICAL);
+}
+
+void ppuMapChr(PPU *ppu, const uint8_t SLOT, uint8_t *bank) {
+	if( ppu->chrBanks[SLOT] == bank ) {
+		return;
+	}
+
+	ppu->chrBanks[SLOT] = bank;
+	memset(&ppu->tileValid[SLOT * PPU_TILES_PER_BANK], 0, PPU_TILES_PER_BANK);
+
+	memset(&ppu->chrChanged[SLOT * PPU_TILES_PER_BANK], true,
+		   PPU_TILES_PER_BANK);
+	ppu->chrChangedAny = true;
+}
+
+/* The same bank can be mapped into more than one slot, so every copy of the
+ * tile at ADDRESS goes
+ */
+static void _invalidateTile(PPU *ppu, const uint16_t ADDRESS) {
+	const uint8_t *BANK = ppu->chrBanks[ADDRESS >> 10];
+	const uint16_t TILE = (ADDRESS & (PPU_CHR_BANK_SIZE - 1)) / 16;
+
+	for( uint8_t i = 0; i < PPU_CHR_BANKS; ++i ) {
+		if( ppu->chrBanks[i] == BANK ) {
+			ppu->tileValid[i * PPU_TILES_PER_BANK + TILE] = false;
+			ppu->chrChanged[i * PPU_TILES_PER_BANK + TILE] = true;
+		}
+	}
+
+	ppu->chrChangedAny = true;
+}
 
-	ppuInit(ppu, CHR_ROM, VERTICAL);
+/* Marks what a write to VRAM index INDEX changes: one tile, or the 4x4 tiles
+ * under an attribute byte
+ */
+static void _dirtyVram(PPU *ppu, const uint16_t INDEX) {
+	const uint16_t NAMETABLE = (INDEX >> 10) & 1;
+	const uint16_t OFFSET = INDEX & 0x03FF;
+	bool *dirty = ppu->bgDirty[NAMETABLE];
+
+	ppu->bgDirtyAny = true;
+
+	if( OFFSET < PPU_NAMETABLE_TILES ) {
+		dirty[OFFSET] = true;
+		return;
+	}
+
+	const uint16_t ROW = (uint16_t)((OFFSET - 0x03C0) / 8 * 4);
+	const uint16_t COL = (uint16_t)((OFFSET - 0x03C0) % 8 * 4);
+
+	/* The last row of attributes only has half its tiles on screen */
+	for( uint16_t y = ROW; y < ROW + 4 && y < 30; ++y ) {
+		memset(&dirty[y * 32 + COL], true, 4);
+	}
+}
+
+const uint8_t *ppuTile(PPU *ppu, const uint16_t TILE) {
+	uint8_t *decoded = ppu->tiles[TILE];
+
+	if( !ppu->tileValid[TILE] ) {
+		tileDecode(ppuChr(ppu, (uint16_t)(TILE * 16)), decoded);
+		ppu->tileValid[TILE] = true;
+	}
+
+	return decoded;
 }
 
 void ppuVramIncrement(PPU *ppu) {
@@ -66,30 +155,29 @@ void ppuVramIncrement(PPU *ppu) {
 }
 
 void ppuWrite(PPU *ppu, const uint8_t VALUE) {
-	uint16_t address = addrGet(&ppu->addr);
-
-	if( address == 0x3F10 || address == 0x3F14 || address == 0x3F18 ||
-		address == 0x3F1C ) {
-		address -= 0x10;
-	}
+	const uint16_t ADDRESS = addrGet(&ppu->addr);
 
-	switch( address ) {
+	switch( ADDRESS ) {
 		case 0 ... 0x1FFF:
-			/* TODO: check chrram */
-			ppu->chrRom[address] = VALUE;
+			/* Writes to CHR ROM are ignored by the cartridge */
+			if( ppu->chrWritable ) {
+				*ppuChr(ppu, ADDRESS) = VALUE;
+				_invalidateTile(ppu, ADDRESS);
+			}
 			break;
 
-			// errPrint(C_RED, "Attempted to write to CHRROM @ %04X", address);
-			// exit(3);
-
-		case 0x2000 ... 0x2FFF:
-			ppu->vram[_mirrorVramAddress(ppu, address)] = VALUE;
-			break;
+		case 0x2000 ... 0x2FFF: {
+			const uint16_t INDEX = _mirrorVramAddress(ppu, ADDRESS);
 
-		case 0x3F00 ... 0x3FFF: {
-			const uint16_t MIRRORED = (uint16_t)((address - 0x3F00) % 32);
-			ppu->palTable[MIRRORED] = VALUE;
+			if( ppu->vram[INDEX] != VALUE ) {
+				ppu->vram[INDEX] = VALUE;
+				_dirtyVram(ppu, INDEX);
+			}
 		} break;
+
+		case 0x3F00 ... 0x3FFF: /* Palette entries are 6 bits */
+			ppu->palTable[_paletteIndex(ADDRESS)] = VALUE & 0x3F;
+			break;
 	}
 
 	ppuVramIncrement(ppu);
@@ -103,12 +191,12 @@ void ppuWriteOAM(PPU *ppu, const uint8_t VALUE) {
 	ppu->oam[ppu->oamAddr++] = VALUE;
 }
 
+/* Starts at OAMADDR and wraps around, leaving OAMADDR where it was */
 void ppuWriteOAMDMA(PPU *ppu, const uint8_t VALUE[256]) {
-	uint8_t v = 0;
+	const size_t START = ppu->oamAddr;
 
-	do {
-		ppu->oam[ppu->oamAddr++] = VALUE[v++];
-	} while( v != 0 );
+	memcpy(&ppu->oam[START], VALUE, 256 - START);
+	memcpy(ppu->oam, &VALUE[256 - START], START);
 }
 
 void ppuWriteControl(PPU *ppu, const uint8_t VALUE) {
@@ -132,45 +220,85 @@ void ppuWriteAddr(PPU *ppu, const uint8_t VALUE) {
 	addrUpdate(&ppu->addr, VALUE);
 }
 
+/* Reads below the palette come back a read late, through internalBuffer.
+ * Palette reads come back straight away, but still fill the buffer with the
+ * nametable byte underneath them
+ */
 uint8_t ppuRead(PPU *ppu) {
-	uint16_t address = addrGet(&ppu->addr);
+	const uint16_t ADDRESS = addrGet(&ppu->addr);
+	const uint8_t RESULT = ppuPeekData(ppu);
+
+	ppu->internalBuffer = ppuPeek(ppu, ADDRESS & 0x2FFF);
 	ppuVramIncrement(ppu);
 
-	switch( address ) {
-		case 0 ... 0x1FFF: {
-			const uint8_t RESULT = ppu->internalBuffer;
-			ppu->internalBuffer = ppu->chrRom[address];
-			return RESULT;
-		}
+	return RESULT;
+}
 
-		case 0x2000 ... 0x2FFF: {
-			const uint8_t RESULT = ppu->internalBuffer;
-			ppu->internalBuffer = ppuReadStatus(ppu).bits;
-			return RESULT;
-		}
+uint8_t ppuPeek(const PPU *ppu, const uint16_t ADDRESS) {
+	const uint16_t MIRRORED = ADDRESS & 0x3FFF;
+
+	switch( MIRRORED ) {
+		case 0 ... 0x1FFF:
+			return ppu->chrBanks[MIRRORED >> 10]
+								[MIRRORED & (PPU_CHR_BANK_SIZE - 1)];
 
-		case 0x3000 ... 0x3EFF: {
-			errPrint(C_RED, "Tried to read %04X, which shouldn't be read!",
-					 address);
-			exit(3);
+		case 0x2000 ... 0x3EFF:
+			return ppu->vram[_mirrorVramAddress(ppu, MIRRORED)];
+
+		default:
+			return ppu->palTable[_paletteIndex(MIRRORED)];
+	}
+}
+
+/* CHR banks and nametables are copied a 1KB run at a time */
+void ppuPeekRange(const PPU *ppu, const uint16_t START, uint8_t *out,
+				  const size_t COUNT) {
+	size_t done = 0;
+
+	while( done < COUNT ) {
+		const uint16_t ADDRESS = (uint16_t)((START + done) & 0x3FFF);
+		const size_t LEFT = COUNT - done;
+
+		if( ADDRESS >= 0x3F00 ) {
+			out[done++] = ppu->palTable[_paletteIndex(ADDRESS)];
+			continue;
 		}
 
-		case 0x3F00 ... 0x3FFF: {
-			ppu->internalBuffer = (uint8_t)(address - 0x1000);
-			if( address == 0x3F10 || address == 0x3F14 || address == 0x3F18 ||
-				address == 0x3F1C ) {
-				address -= 0x10;
-			}
+		/* Runs end at the next 1KB boundary, or where the palette starts */
+		const size_t OFFSET = ADDRESS & (PPU_CHR_BANK_SIZE - 1);
+		size_t run = PPU_CHR_BANK_SIZE - OFFSET;
 
-			return ppu->palTable[address - 0x3F00];
+		if( ADDRESS >= 0x3C00 ) {
+			run = 0x3F00 - (size_t)ADDRESS;
+		}
+		if( run > LEFT ) {
+			run = LEFT;
 		}
 
-		default:
-			errPrint(C_RED, "Unexpected read to mirrored space %04X", address);
-			exit(3);
+		const uint8_t *SOURCE =
+			(ADDRESS < 0x2000)
+				? &ppu->chrBanks[ADDRESS >> 10][OFFSET]
+				: &ppu->vram[_mirrorVramAddress(ppu, ADDRESS)];
+
+		memcpy(&out[done], SOURCE, run);
+		done += run;
 	}
 }
 
+uint8_t ppuPeekData(const PPU *ppu) {
+	const uint16_t ADDRESS = ppu->addr.address.full & 0x3FFF;
+
+	if( ADDRESS >= 0x3F00 ) {
+		return ppu->palTable[_paletteIndex(ADDRESS)];
+	}
+
+	return ppu->internalBuffer;
+}
+
+void ppuPeekOAM(const PPU *ppu, uint8_t out[256]) {
+	memcpy(out, ppu->oam, 256);
+}
+
 uint8_t ppuReadOAM(PPU *ppu) {
 	return ppu->oam[ppu->oamAddr];
 }
@@ -186,226 +314,221 @@ StatusReg ppuReadStatus(PPU *ppu) {
 	return STATUS;
 }
 
-static bool _isZeroHit(PPU *ppu) {
-	const uint8_t TILE_X = ppu->oam[0];
-	const uint8_t TILE_Y = ppu->oam[3];
+/* Draws tile INDEX of NAMETABLE into its background plane */
+static void _drawBGTile(PPU *ppu, const uint8_t NAMETABLE, const uint16_t INDEX) {
+	const uint8_t *VRAM = &ppu->vram[NAMETABLE * 0x0400];
 
-	if( TILE_Y == ppu->scanline && TILE_X <= ppu->cycles &&
-		ppu->mask.showSpr ) {
-		return true;
-	}
+	const uint16_t ROW = INDEX / 32;
+	const uint16_t COL = INDEX % 32;
 
-	return false;
-}
+	const uint8_t TILE = VRAM[INDEX];
+	const uint8_t ATTR = VRAM[0x03C0 + (ROW / 4) * 8 + COL / 4];
 
-bool ppuTick(PPU *ppu, const uint8_t CYCLES) {
-	ppu->cycles += CYCLES;
+	/* Each attribute byte covers 4x4 tiles, 2 bits per 2x2 quadrant */
+	const uint8_t PALETTE =
+		(uint8_t)(((ATTR >> (((ROW & 2) << 1) | (COL & 2))) & 3) * 4);
 
-	if( ppu->cycles >= 341 ) {
-		if( _isZeroHit(ppu) ) {
-			ppu->status.sprZeroHit = 1;
-		}
+	const uint8_t *PIXELS = ppuTile(ppu, (uint16_t)(ppu->bgPlaneTiles + TILE));
 
-		ppu->cycles -= 341;
-		++ppu->scanline;
-
-		if( ppu->scanline == 241 ) {
-			ppu->status.vblankStarted = 1;
-			ppu->status.sprZeroHit = 0;
+	for( uint8_t y = 0; y < 8; ++y ) {
+		uint8_t *out = &ppu->bgPlane[NAMETABLE][ROW * 8 + y][COL * 8];
 
-			if( ppu->control.generateNMI ) {
-				ppu->nmiInterrupt = true;
-			}
-
-			return false;
-		}
-
-		if( ppu->scanline >= 262 ) {
-			ppu->scanline = 0;
-			ppu->nmiInterrupt = false;
-
-			ppu->status.vblankStarted = 0;
-			ppu->status.sprZeroHit = 0;
-			return true;
+		for( uint8_t x = 0; x < 8; ++x ) {
+			const uint8_t VALUE = PIXELS[y * 8 + x];
+			out[x] = (VALUE != 0) ? (uint8_t)(PALETTE + VALUE) : 0;
 		}
 	}
-
-	return false;
 }
 
-void _getBGPalette(PPU *ppu, const size_t COL, const size_t ROW,
-				   uint8_t attrTable[64], uint8_t palette[4]) {
-	const uint16_t ATTR_TABLE_IDX = (uint16_t)((ROW / 4) * 8 + (COL / 4));
-	const uint8_t ATTR_BYTE = attrTable[ATTR_TABLE_IDX];
+/* Redraws whatever's changed in the background planes since the last line */
+static void _refreshBG(PPU *ppu) {
+	const uint16_t BG_TILES = controlBGPatternAddr(&ppu->control) / 16;
 
-	uint8_t paletteIdx = 0;
+	if( ppu->bgPlaneTiles != BG_TILES ) {
+		ppu->bgPlaneTiles = BG_TILES;
 
-	const uint8_t INDEX = (uint8_t)((((COL % 4) / 2) << 1) | ((ROW % 4) / 2));
-	switch( INDEX ) {
-		case 0:
-			paletteIdx = ATTR_BYTE & 3;
-			break;
-		case 1:
-			paletteIdx = (ATTR_BYTE >> 4) & 3;
-			break;
-		case 2:
-			paletteIdx = (ATTR_BYTE >> 2) & 3;
-			break;
-		case 3:
-			paletteIdx = (ATTR_BYTE >> 6) & 3;
-			break;
+		memset(ppu->bgDirty, true, sizeof(ppu->bgDirty));
+		ppu->bgDirtyAny = true;
 	}
 
-	uint8_t palStart = (uint8_t)(1 + (paletteIdx * 4));
+	if( !ppu->bgDirtyAny && !ppu->chrChangedAny ) {
+		return;
+	}
 
-	palette[0] = ppu->palTable[0];
-	palette[1] = ppu->palTable[palStart];
-	palette[2] = ppu->palTable[palStart + 1];
-	palette[3] = ppu->palTable[palStart + 2];
-}
+	for( uint8_t n = 0; n < PPU_NAMETABLES; ++n ) {
+		const uint8_t *VRAM = &ppu->vram[n * 0x0400];
 
-void _getSprPalette(PPU *ppu, const uint8_t IDX, uint8_t palette[4]) {
-	uint8_t palStart = (uint8_t)(0x11 + (IDX * 4));
+		for( uint16_t i = 0; i < PPU_NAMETABLE_TILES; ++i ) {
+			if( ppu->bgDirty[n][i] || ppu->chrChanged[BG_TILES + VRAM[i]] ) {
+				_drawBGTile(ppu, n, i);
+				ppu->bgDirty[n][i] = false;
+			}
+		}
+	}
 
-	palette[0] = 0;
-	palette[1] = ppu->palTable[palStart++];
-	palette[2] = ppu->palTable[palStart++];
-	palette[3] = ppu->palTable[palStart];
+	memset(ppu->chrChanged, 0, sizeof(ppu->chrChanged));
+	ppu->chrChangedAny = false;
+	ppu->bgDirtyAny = false;
 }
 
-static void _renderNametable(PPU *ppu, uint8_t nametable[1024], Rect viewport,
-							 const int64_t SHIFT_X, const int64_t SHIFT_Y) {
-	const uint16_t BG_BANK = controlBGPatternAddr(&ppu->control);
-
-	uint8_t attrTable[64];
-	memcpy(attrTable, nametable + 0x03C0, 64);
+/* Background for one line, composed from the planes. Horizontal scroll and
+ * the nametable it starts in are read as they are now, vertical scroll as it
+ * was when the frame started
+ */
+static void _renderBGLine(PPU *ppu, const uint16_t LINE, uint8_t line[SCR_W]) {
+	_refreshBG(ppu);
+
+	const size_t SCROLL_X =
+		ppu->scroll.x + (size_t)(ppu->control.nametableAddr & 1) * SCR_W;
+	const size_t Y = (ppu->frameScrollY + LINE) % (SCR_H * 2);
+
+	/* At most two runs, one either side of where the nametables meet */
+	size_t px = 0;
+	while( px < SCR_W ) {
+		const size_t X = (SCROLL_X + px) % (SCR_W * 2);
+
+		const uint16_t NAMETABLE =
+			(uint16_t)(0x2000 + ((Y >= SCR_H) * 2 + (X >= SCR_W)) * 0x0400);
+		const uint8_t PHYSICAL = (_mirrorVramAddress(ppu, NAMETABLE) >> 10) & 1;
+
+		const uint8_t *ROW = &ppu->bgPlane[PHYSICAL][Y % SCR_H][X % SCR_W];
+		size_t run = SCR_W - X % SCR_W;
+		if( run > SCR_W - px ) {
+			run = SCR_W - px;
+		}
 
-	for( uint16_t i = 0; i < 0x03C0; ++i ) {
-		const uint16_t TILE_BYTE = (uint16_t)nametable[i];
+		for( size_t i = 0; i < run; ++i ) {
+			line[px + i] = ppu->palTable[ROW[i]];
+		}
 
-		const uint8_t TILE_X = i % 32;
-		const uint8_t TILE_Y = (uint8_t)(i / 32);
+		px += run;
+	}
+}
 
-		uint8_t tile[16];
-		memcpy(tile, ppu->chrRom + (BG_BANK + TILE_BYTE * 16), 16);
+/* Sprites drawn over LINE. Lower OAM entries go on top */
+static void _renderSprLine(PPU *ppu, const uint16_t LINE, uint8_t line[SCR_W]) {
+	const uint16_t SPR_TILES = controlSprPatternAddr(&ppu->control) / 16;
 
-		uint8_t palette[4];
-		_getBGPalette(ppu, TILE_X, TILE_Y, attrTable, palette);
+	for( int16_t i = 252; i >= 0; i -= 4 ) {
+		const uint8_t *SPRITE = &ppu->oam[i];
 
-		for( uint8_t y = 0; y < 8; ++y ) {
-			uint8_t upper = tile[y];
-			uint8_t lower = tile[y + 8];
+		const uint8_t TOP = SPRITE[0];
+		const uint8_t ATTR = SPRITE[2];
+		const uint8_t LEFT = SPRITE[3];
 
-			for( uint8_t x = 7; x != 255; --x ) {
-				const uint8_t VALUE =
-					(uint8_t)(((1 & lower) << 1) | (1 & upper));
+		if( LINE < TOP || LINE - TOP > 7 ) {
+			continue;
+		}
 
-				upper >>= 1;
-				lower >>= 1;
+		const uint16_t ROW = (uint16_t)(LINE - TOP);
+		const uint8_t *PIXELS =
+			&ppuTile(ppu, (uint16_t)(SPR_TILES + SPRITE[1]))
+				[((ATTR & 0x80) ? 7 - ROW : ROW) * 8];
 
-				SDL_Color rgb = SYS_PAL[palette[VALUE]];
+		const uint8_t PALETTE = (uint8_t)(0x10 + (ATTR & 3) * 4);
+		const bool FLIP_H = (ATTR & 0x40) != 0;
 
-				const size_t PX = (size_t)(TILE_X * 8 + x);
-				const size_t PY = (size_t)(TILE_Y * 8 + y);
+		for( uint8_t x = 0; x < 8 && LEFT + x < SCR_W; ++x ) {
+			const uint8_t VALUE = PIXELS[FLIP_H ? 7 - x : x];
 
-				if( PX >= viewport.x1 && PX < viewport.x2 &&
-					PY >= viewport.y1 && PY < viewport.y2 ) {
-					frameSetPixel(&ppu->frame, (size_t)(SHIFT_X + PX),
-								  (size_t)(SHIFT_Y + PY), rgb);
-				}
+			if( VALUE != 0 ) {
+				line[LEFT + x] = ppu->palTable[PALETTE + VALUE];
 			}
 		}
 	}
 }
 
-void ppuRender(PPU *ppu) {
-	/* Draw BG */
-	size_t scrollX = (size_t)ppu->scroll.x;
-	size_t scrollY = (size_t)ppu->scroll.y;
+/* Draws a visible line with the registers in effect on it. Anything that
+ * writes them catches the PPU up first, so mid-frame changes land on the
+ * right line
+ */
+static void _renderScanline(PPU *ppu, const uint16_t LINE) {
+	uint8_t *line = &ppu->frame.pixels[LINE * SCR_W];
+
+	if( ppu->mask.showBG ) {
+		_renderBGLine(ppu, LINE, line);
+	} else {
+		memset(line, ppu->palTable[0], SCR_W);
+	}
 
-	uint8_t mainNametable[1024];
-	uint8_t secNametable[1024];
+	if( ppu->mask.showSpr ) {
+		_renderSprLine(ppu, LINE, line);
+	}
 
-	if( ppu->mirroring == VERTICAL ) {
-		switch( controlNametableAddr(&ppu->control) ) {
-			case 0x2000:
-			case 0x2800:
-				memcpy(mainNametable, ppu->vram, 1024);
-				memcpy(secNametable, ppu->vram + 0x0400, 1024);
-				break;
-			case 0x2400:
-			case 0x2C00:
-				memcpy(mainNametable, ppu->vram + 0x0400, 1024);
-				memcpy(secNametable, ppu->vram, 1024);
-				break;
-		}
-	} else if( ppu->mirroring == HORIZONTAL ) {
-		switch( controlNametableAddr(&ppu->control) ) {
-			case 0x2000:
-			case 0x2400:
-				memcpy(mainNametable, ppu->vram, 1024);
-				memcpy(secNametable, ppu->vram + 0x0400, 1024);
-				break;
-			case 0x2800:
-			case 0x2C00:
-				memcpy(mainNametable, ppu->vram + 0x0400, 1024);
-				memcpy(secNametable, ppu->vram, 1024);
-				break;
+	/* Greyscale keeps only the column of the palette that's grey */
+	if( ppu->mask.greyscale ) {
+		for( size_t x = 0; x < SCR_W; ++x ) {
+			line[x] &= 0x30;
 		}
 	}
 
-	_renderNametable(ppu, mainNametable, RECT(scrollX, scrollY, SCR_W, SCR_H),
-					 -((int64_t)scrollX), -((int64_t)scrollY));
+	ppu->frame.emphasis[LINE] = ppu->mask.bits >> 5;
+}
+
+static bool _isZeroHit(PPU *ppu) {
+	const uint8_t TILE_X = ppu->oam[0];
+	const uint8_t TILE_Y = ppu->oam[3];
 
-	if( (int64_t)(scrollX) > 0 ) {
-		const int64_t SX = (int64_t)(SCR_W) - scrollX;
-		_renderNametable(ppu, secNametable, RECT(0, 0, scrollX, SCR_H), SX, 0);
-	} else if( (int64_t)(scrollY) > 0 ) {
-		const int64_t SY = (int64_t)(SCR_H) - scrollY;
-		_renderNametable(ppu, secNametable, RECT(0, 0, SCR_W, scrollY), 0, SY);
+	if( TILE_Y == ppu->scanline && TILE_X <= ppu->cycles &&
+		ppu->mask.showSpr ) {
+		return true;
 	}
 
-	/* Draw sprites */
-	const uint16_t SPR_BANK = controlSprPatternAddr(&ppu->control);
+	return false;
+}
 
-	for( int16_t i = 252; i >= 0; i -= 4 ) {
-		const uint8_t TILE_Y = ppu->oam[i];
-		const uint8_t TILE_BYTE = ppu->oam[i + 1];
-		const uint8_t TILE_ATTR = ppu->oam[i + 2];
-		const uint8_t TILE_X = ppu->oam[i + 3];
+/* Advances the PPU, which may cross several scanlines when it's being caught
+ * up, drawing each visible one as it's finished. Returns true once the frame
+ * is done
+ */
+bool ppuTick(PPU *ppu, const size_t CYCLES) {
+	bool frameDone = false;
+	ppu->cycles += CYCLES;
 
-		const bool FLIP_V = ((TILE_ATTR >> 7) & 1) == 1;
-		const bool FLIP_H = ((TILE_ATTR >> 6) & 1) == 0;
+	while( ppu->cycles >= 341 ) {
+		if( _isZeroHit(ppu) ) {
+			ppu->status.sprZeroHit = 1;
+		}
 
-		const uint8_t PAL_INDEX = TILE_ATTR & 3;
+		if( ppu->scanline < SCR_H ) {
+			_renderScanline(ppu, ppu->scanline);
+		}
 
-		uint8_t palette[4];
-		_getSprPalette(ppu, PAL_INDEX, palette);
+		ppu->cycles -= 341;
+		++ppu->scanline;
 
-		uint8_t tile[16];
-		memcpy(tile, ppu->chrRom + (SPR_BANK + TILE_BYTE * 16), 16);
+		if( ppu->scanline == 241 ) {
+			ppu->status.vblankStarted = 1;
+			ppu->status.sprZeroHit = 0;
 
-		for( uint8_t y = 0; y < 8; ++y ) {
-			uint8_t upper = tile[y];
-			uint8_t lower = tile[y + 8];
+			if( ppu->control.generateNMI ) {
+				ppu->nmiInterrupt = true;
+			}
+		} else if( ppu->scanline >= 262 ) {
+			ppu->scanline = 0;
+			ppu->nmiInterrupt = false;
 
-			for( uint8_t x = 0; x < 8; ++x ) {
-				const uint8_t VALUE =
-					(uint8_t)(((1 & lower) << 1) | (1 & upper));
+			/* Like the PPU, only take vertical scroll at the start of a frame */
+			ppu->frameScrollY =
+				(uint16_t)(ppu->scroll.y +
+						   ((ppu->control.nametableAddr >> 1) & 1) * SCR_H);
 
-				upper >>= 1;
-				lower >>= 1;
+			ppu->status.vblankStarted = 0;
+			ppu->status.sprZeroHit = 0;
+			frameDone = true;
+		}
+	}
 
-				if( VALUE == 0 ) continue;
-				SDL_Color rgb = SYS_PAL[palette[VALUE]];
+	return frameDone;
+}
 
-				const size_t TX_FINAL =
-					(size_t)(FLIP_H ? TILE_X + 7 - x : TILE_X + x);
-				const size_t TY_FINAL =
-					(size_t)(FLIP_V ? TILE_Y + 7 - y : TILE_Y + y);
+/* Returns how many PPU cycles are left until SCANLINE starts, in the next
+ * frame if it's already been reached in this one. 262 is the end of the frame
+ */
+size_t ppuCyclesUntil(PPU *ppu, const uint16_t SCANLINE) {
+	const size_t LINES = (SCANLINE > ppu->scanline)
+							 ? (size_t)(SCANLINE - ppu->scanline)
+							 : (size_t)(262 - ppu->scanline + SCANLINE);
 
-				frameSetPixel(&ppu->frame, TX_FINAL, TY_FINAL, rgb);
-			}
-		}
-	}
+	return LINES * 341 - ppu->cycles;
 }
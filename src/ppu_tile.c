@@ -0,0 +1,139 @@
+#include "ppu_tile.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TILE_X86
+#include <immintrin.h>
+#endif
+
+static void _decodeScalar(const uint8_t PLANES[16], uint8_t out[64]) {
+	for( uint8_t y = 0; y < 8; ++y ) {
+		const uint8_t LO = PLANES[y];
+		const uint8_t HI = PLANES[y + 8];
+
+		for( uint8_t x = 0; x < 8; ++x ) {
+			const uint8_t BIT = 7 - x;
+			out[y * 8 + x] =
+				(uint8_t)(((HI >> BIT) & 1) << 1 | ((LO >> BIT) & 1));
+		}
+	}
+}
+
+#ifdef TILE_X86
+
+/* Each pixel's bit in its row byte, leftmost first */
+#define TILE_BITS 0x0102040810204080LL
+
+/* Spreads two row bytes (rows ROW and ROW + 1) across 8 lanes each, and
+ * turns each lane into 0 or VALUE depending on its pixel's bit
+ */
+__attribute__((target("sse2"))) static inline __m128i
+_expandSSE2(const uint8_t *PLANE, const uint8_t ROW, const __m128i VALUE) {
+	const __m128i BITS = _mm_set1_epi64x(TILE_BITS);
+
+	__m128i rows = _mm_cvtsi32_si128(PLANE[ROW] | PLANE[ROW + 1] << 8);
+	rows = _mm_unpacklo_epi8(rows, rows);
+	rows = _mm_unpacklo_epi16(rows, rows);
+	rows = _mm_unpacklo_epi32(rows, rows);
+
+	const __m128i SET = _mm_cmpeq_epi8(_mm_and_si128(rows, BITS), BITS);
+	return _mm_and_si128(SET, VALUE);
+}
+
+__attribute__((target("sse2"))) static void
+_decodeSSE2(const uint8_t PLANES[16], uint8_t out[64]) {
+	const __m128i ONE = _mm_set1_epi8(1);
+	const __m128i TWO = _mm_set1_epi8(2);
+
+	for( uint8_t y = 0; y < 8; y += 2 ) {
+		const __m128i PIXELS = _mm_or_si128(_expandSSE2(PLANES, y, ONE),
+											_expandSSE2(PLANES + 8, y, TWO));
+		_mm_storeu_si128((__m128i *)&out[y * 8], PIXELS);
+	}
+}
+
+/* Same as the SSE2 one, 4 rows at a time. The byte shuffle stays within
+ * 128 bit lanes, so each lane picks its own two rows out of all 8
+ */
+__attribute__((target("avx2"))) static inline __m256i
+_expandAVX2(const uint64_t ROWS, const __m256i PICK, const __m256i VALUE) {
+	const __m256i BITS = _mm256_set1_epi64x(TILE_BITS);
+
+	const __m256i SPREAD =
+		_mm256_shuffle_epi8(_mm256_set1_epi64x((long long)ROWS), PICK);
+	const __m256i SET = _mm256_cmpeq_epi8(_mm256_and_si256(SPREAD, BITS), BITS);
+
+	return _mm256_and_si256(SET, VALUE);
+}
+
+__attribute__((target("avx2"))) static void
+_decodeAVX2(const uint8_t PLANES[16], uint8_t out[64]) {
+	const __m256i ONE = _mm256_set1_epi8(1);
+	const __m256i TWO = _mm256_set1_epi8(2);
+
+	uint64_t lo, hi;
+	memcpy(&lo, PLANES, 8);
+	memcpy(&hi, PLANES + 8, 8);
+
+	for( uint8_t y = 0; y < 8; y += 4 ) {
+		const __m256i PICK = _mm256_setr_epi64x(
+			0x0101010101010101LL * y, 0x0101010101010101LL * (y + 1),
+			0x0101010101010101LL * (y + 2), 0x0101010101010101LL * (y + 3));
+
+		const __m256i PIXELS = _mm256_or_si256(_expandAVX2(lo, PICK, ONE),
+											   _expandAVX2(hi, PICK, TWO));
+		_mm256_storeu_si256((__m256i *)&out[y * 8], PIXELS);
+	}
+}
+
+#endif
+
+TileDecodeFn tileKernel(const TileKernel KERNEL) {
+#ifdef TILE_X86
+	__builtin_cpu_init();
+#endif
+
+	switch( KERNEL ) {
+		case TILE_SCALAR:
+			return _decodeScalar;
+
+#ifdef TILE_X86
+		case TILE_SSE2:
+			return __builtin_cpu_supports("sse2") ? _decodeSSE2 : NULL;
+
+		case TILE_AVX2:
+			return __builtin_cpu_supports("avx2") ? _decodeAVX2 : NULL;
+#endif
+
+		default:
+			return NULL;
+	}
+}
+
+const char *tileKernelName(const TileKernel KERNEL) {
+	static const char *NAMES[TILE_KERNELS] = {"scalar", "SSE2", "AVX2"};
+	return NAMES[KERNEL];
+}
+
+static void _decodeFirst(const uint8_t PLANES[16], uint8_t out[64]);
+
+static TileDecodeFn gDecode = _decodeFirst;
+
+/* Stands in for the kernel until the first decode picks one */
+static void _decodeFirst(const uint8_t PLANES[16], uint8_t out[64]) {
+	for( int kernel = TILE_KERNELS - 1; kernel >= TILE_SCALAR; --kernel ) {
+		TileDecodeFn decode = tileKernel((TileKernel)kernel);
+
+		if( decode != NULL ) {
+			gDecode = decode;
+			break;
+		}
+	}
+
+	gDecode(PLANES, out);
+}
+
+void tileDecode(const uint8_t PLANES[16], uint8_t out[64]) {
+	gDecode(PLANES, out);
+}
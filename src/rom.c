@@ -5,9 +5,12 @@
 #include <string.h>
 
 #include "error.h"
+#include "mapper.h"
+#include "save.h"
 
 #define PRGROM_PAGE_SIZE (16 * 1024)
 #define CHRROM_PAGE_SIZE (8 * 1024)
+#define PRGRAM_PAGE_SIZE (8 * 1024)
 
 #define START_ADDR ((0xFFFC - 0x8000) & 0x3FFF)
 
@@ -29,6 +32,11 @@ bool romInit(ROM *rom, const uint8_t *RAW) {
 		return false;
 	}
 
+	if( !mapperIsSupported(rom->mapper) ) {
+		errPrint(C_YELLOW, "Mapper %d ainda nao e suportado", rom->mapper);
+		return false;
+	}
+
 	if( (RAW[6] & 8) != 0 ) {
 		rom->mirroring = FOUR_SCREEN;
 	} else if( (RAW[6] & 1) != 0 ) {
@@ -40,6 +48,10 @@ bool romInit(ROM *rom, const uint8_t *RAW) {
 	rom->prgSize = RAW[4] * PRGROM_PAGE_SIZE;
 	rom->chrSize = RAW[5] * CHRROM_PAGE_SIZE;
 
+	/* Old headers leave the PRG RAM size at 0, which means 8KB */
+	rom->prgRamSize = ((RAW[8] != 0) ? RAW[8] : 1) * PRGRAM_PAGE_SIZE;
+	rom->battery = (RAW[6] & 2) != 0;
+
 	const size_t SKIP_TRAINER = ((RAW[6] & 4) != 0) ? 512 : 0;
 
 	const size_t PRGROM_START = 16 + SKIP_TRAINER;
@@ -48,8 +60,18 @@ bool romInit(ROM *rom, const uint8_t *RAW) {
 	rom->prgRom = malloc(rom->prgSize);
 	memcpy(rom->prgRom, RAW + PRGROM_START, rom->prgSize);
 
-	rom->chrRom = malloc(rom->chrSize);
-	memcpy(rom->chrRom, RAW + CHRROM_START, rom->chrSize);
+	rom->chrRam = (rom->chrSize == 0);
+
+	if( rom->chrRam ) {
+		rom->chrSize = CHRROM_PAGE_SIZE;
+		rom->chrRom = calloc(1, rom->chrSize);
+	} else {
+		rom->chrRom = malloc(rom->chrSize);
+		memcpy(rom->chrRom, RAW + CHRROM_START, rom->chrSize);
+	}
+
+	rom->prgRam = calloc(1, rom->prgRamSize);
+	rom->prgRamMapped = false;
 
 	return true;
 }
@@ -57,10 +79,56 @@ bool romInit(ROM *rom, const uint8_t *RAW) {
 void romFree(ROM *rom) {
 	free(rom->prgRom);
 	free(rom->chrRom);
+
+	if( rom->prgRamMapped ) {
+		saveUnmap(rom->prgRam, rom->prgRamSize);
+	} else {
+		free(rom->prgRam);
+	}
+}
+
+/* The save file sits next to the ROM, with its extension swapped for .sav */
+static void _loadSave(ROM *rom, const char *PATH) {
+	char savePath[4096];
+
+	/* Only a dot in the file name itself starts the extension */
+	const char *name = PATH;
+	for( const char *c = PATH; *c != '\0'; ++c ) {
+		if( *c == '/' || *c == '\\' ) {
+			name = c + 1;
+		}
+	}
+
+	const char *dot = strrchr(name, '.');
+	const size_t STEM = (dot != NULL) ? (size_t)(dot - PATH) : strlen(PATH);
+
+	if( STEM + sizeof(".sav") > sizeof(savePath) ) {
+		errPrint(C_YELLOW, "Save path for '%s' is too long", PATH);
+		return;
+	}
+
+	memcpy(savePath, PATH, STEM);
+	memcpy(savePath + STEM, ".sav", sizeof(".sav"));
+
+	uint8_t *data = saveMap(savePath, rom->prgRamSize);
+	if( data == NULL ) {
+		errPrint(C_YELLOW, "Couldn't map '%s', saves won't be kept", savePath);
+		return;
+	}
+
+	free(rom->prgRam);
+	rom->prgRam = data;
+	rom->prgRamMapped = true;
 }
 
 void romCreateTestROM(ROM *rom) {
-	romInit(rom, TEST_ROM);
+	/* romInit expects the PRG ROM page right after the header, so a blank one
+	 * is appended to it
+	 */
+	static uint8_t raw[sizeof(TEST_ROM) + PRGROM_PAGE_SIZE];
+	memcpy(raw, TEST_ROM, sizeof(TEST_ROM));
+
+	romInit(rom, raw);
 	rom->prgRom[START_ADDR + 1] = 0x06;
 }
 
@@ -90,5 +158,14 @@ void romCreateFromFile(ROM *rom, const char *PATH) {
 	buffer[BYTES_READ] = '\0';
 	fclose(file);
 
-	romInit(rom, buffer);
+	const bool LOADED = romInit(rom, buffer);
+	free(buffer);
+
+	if( !LOADED ) {
+		exit(74);
+	}
+
+	if( rom->battery ) {
+		_loadSave(rom, PATH);
+	}
 }
@@ -0,0 +1,69 @@
+#include "save.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+uint8_t *saveMap(const char *PATH, const size_t SIZE) {
+	HANDLE file = CreateFileA(PATH, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+							  OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if( file == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+
+	/* Mapping past the end of the file grows it, zero filled */
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0,
+										(DWORD)SIZE, NULL);
+	CloseHandle(file);
+
+	if( mapping == NULL ) {
+		return NULL;
+	}
+
+	/* The view keeps the mapping alive on its own */
+	uint8_t *data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, SIZE);
+	CloseHandle(mapping);
+
+	return data;
+}
+
+void saveUnmap(uint8_t *data, const size_t SIZE) {
+	UNUSED(SIZE);
+
+	UnmapViewOfFile(data);
+}
+
+#else
+
+uint8_t *saveMap(const char *PATH, const size_t SIZE) {
+	const int FD = open(PATH, O_RDWR | O_CREAT, 0644);
+	if( FD < 0 ) {
+		return NULL;
+	}
+
+	/* Grows the file (zero filled) if it's new or from a smaller board */
+	struct stat info;
+	if( fstat(FD, &info) != 0 ||
+		((size_t)info.st_size < SIZE && ftruncate(FD, (off_t)SIZE) != 0) ) {
+		close(FD);
+		return NULL;
+	}
+
+	void *data = mmap(NULL, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, FD, 0);
+	close(FD);
+
+	return (data == MAP_FAILED) ? NULL : data;
+}
+
+void saveUnmap(uint8_t *data, const size_t SIZE) {
+	munmap(data, SIZE);
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "scheduler.h"
+
+static void _updateNext(Scheduler *sched) {
+	sched->next = (sched->count != 0) ? sched->queue[0].time : SCHED_NEVER;
+}
+
+void schedInit(Scheduler *sched) {
+	sched->count = 0;
+	_updateNext(sched);
+}
+
+void schedAdd(Scheduler *sched, const EventType TYPE, const size_t TIME) {
+	schedCancel(sched, TYPE);
+
+	uint8_t i = sched->count++;
+	while( i > 0 && sched->queue[i - 1].time > TIME ) {
+		sched->queue[i] = sched->queue[i - 1];
+		--i;
+	}
+
+	sched->queue[i] = (Event){TIME, TYPE};
+	_updateNext(sched);
+}
+
+void schedCancel(Scheduler *sched, const EventType TYPE) {
+	for( uint8_t i = 0; i < sched->count; ++i ) {
+		if( sched->queue[i].type != TYPE ) {
+			continue;
+		}
+
+		--sched->count;
+		for( uint8_t j = i; j < sched->count; ++j ) {
+			sched->queue[j] = sched->queue[j + 1];
+		}
+
+		break;
+	}
+
+	_updateNext(sched);
+}
+
+bool schedPop(Scheduler *sched, const size_t NOW, EventType *type) {
+	if( sched->count == 0 || sched->queue[0].time > NOW ) {
+		return false;
+	}
+
+	*type = sched->queue[0].type;
+
+	--sched->count;
+	for( uint8_t i = 0; i < sched->count; ++i ) {
+		sched->queue[i] = sched->queue[i + 1];
+	}
+
+	_updateNext(sched);
+	return true;
+}
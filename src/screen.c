@@ -1,9 +1,13 @@
 #include "screen.h"
 
 #include "error.h"
+#include "frame.h"
 
 Screen gScreen = {0};
 
+static FrameLUT gLUT;
+static uint32_t gPixels[FRAME_SIZE];
+
 void screenInit(Screen *screen) {
 	screen->window = SDL_CreateWindow("NESINC Emulator", SDL_WINDOWPOS_CENTERED,
 									  SDL_WINDOWPOS_CENTERED, SCR_W * SCR_SCALE,
@@ -22,12 +26,15 @@ void screenInit(Screen *screen) {
 
 	SDL_RenderSetScale(screen->renderer, SCR_SCALE, SCR_SCALE);
 
-	screen->texture = SDL_CreateTexture(screen->renderer, SDL_PIXELFORMAT_RGB24,
-										SDL_TEXTUREACCESS_TARGET, SCR_W, SCR_H);
+	screen->texture =
+		SDL_CreateTexture(screen->renderer, SDL_PIXELFORMAT_ARGB8888,
+						  SDL_TEXTUREACCESS_STREAMING, SCR_W, SCR_H);
 	if( !screen->texture ) {
 		errPrint(C_RED, "Unable to create texture.\n SDL_Error: %s",
 				 SDL_GetError());
 	}
+
+	frameLUTInitARGB(&gLUT);
 }
 
 void screenFree(Screen *screen) {
@@ -35,3 +42,11 @@ void screenFree(Screen *screen) {
 	SDL_DestroyRenderer(screen->renderer);
 	SDL_DestroyWindow(screen->window);
 }
+
+void screenPresent(Screen *screen, const Frame *FRAME) {
+	frameConvert32(FRAME, &gLUT, gPixels);
+
+	SDL_UpdateTexture(screen->texture, NULL, gPixels, SCR_W * sizeof(uint32_t));
+	SDL_RenderCopy(screen->renderer, screen->texture, NULL, NULL);
+	SDL_RenderPresent(screen->renderer);
+}
@@ -3,10 +3,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "bus.h"
 #include "cpu.h"
 #include "joypad.h"
+#include "machine.h"
 #include "ppu.h"
+#include "ppu_tile.h"
 #include "rom.h"
+#include "save.h"
+#include "trace.h"
+#include "watch.h"
 
 #define XSTR(X) #X
 #define STR(X) XSTR(X)
@@ -30,13 +36,13 @@
 	}                                       \
 	printf("OK\n");
 
-#define RUN_ROM(F)              \
-	printf("\n");               \
-	ROM rom;                    \
-	romCreateFromFile(&rom, F); \
-	CPU cpu;                    \
-	cpuInitFromROM(&cpu, rom);  \
-	cpuRun(&cpu);
+#define RUN_ROM(F)                          \
+	printf("\n");                           \
+	ROM rom;                                \
+	romCreateFromFile(&rom, F);             \
+	Machine *machine = machineCreate(&rom); \
+	machineRun(machine);                    \
+	machineDestroy(machine);
 
 #define TEST_PPU \
 	PPU ppu;     \
@@ -46,20 +52,25 @@
 	Joypad joy;  \
 	joyInit(&joy)
 
+#define TEST_MACHINE(CODE, S)                  \
+	Machine *machine = _loadTestCode(CODE, S); \
+	CPU *cpu = machineCPU(machine)
+
 #define TEST(S, ...)                                   \
-	CPU cpu;                                           \
 	const uint8_t PROG[(S) + 1] = {__VA_ARGS__, 0x00}; \
-	_loadTestCode(&cpu, PROG, S);                      \
-	cpuRun(&cpu)
+	TEST_MACHINE(PROG, S);                             \
+	cpuRun(cpu)
 
 #define RET(C)                                          \
 	do {                                                \
-		if( (C) ) {                                     \
-			return true;                                \
-		} else                                          \
+		const bool PASSED = (C);                        \
+		if( !PASSED ) {                                 \
 			printf("Test failed!\n\nDumping CPU...\n"); \
-		_dumpCPU(&cpu);                                 \
-		return false;                                   \
+			_dumpCPU(cpu);                              \
+		}                                               \
+                                                        \
+		machineDestroy(machine);                        \
+		return PASSED;                                  \
 	} while( false )
 
 static void _dumpCPU(CPU *cpu) {
@@ -72,187 +83,366 @@ static void _dumpCPU(CPU *cpu) {
 		   cpu->status.interrupt, cpu->status.zero, cpu->status.carry);
 }
 
-static void _loadTestCode(CPU *cpu, const uint8_t *CODE, const uint16_t SIZE) {
+static Machine *_loadTestCode(const uint8_t *CODE, const uint16_t SIZE) {
 	ROM rom;
 	romCreateTestROM(&rom);
 
-	cpuInitFromROM(cpu, rom);
-	cpuLoad(cpu, CODE, SIZE);
+	Machine *machine = machineCreate(&rom);
+	cpuLoad(machineCPU(machine), CODE, SIZE);
+
+	return machine;
+}
+
+/* Exhaustive ALU checks
+ *
+ * The program below runs OPCODE for every value of A, every operand and both
+ * carries, and writes the result and P to $0200/$0201 each time. A watch on
+ * those checks them against a plain model of the instruction, so every pair
+ * goes through the real CPU without a cpuRun per pair
+ */
+typedef struct _AluSweep {
+	uint8_t opcode;
+	uint8_t result;
+	uint32_t checked;
+	uint32_t failed;
+} AluSweep;
+
+#define ALU_SWEEP_PAIRS (256 * 256 * 2)
+
+/* What OPCODE leaves in A (or the shifted byte) and in NVZC */
+static void _aluModel(const uint8_t OPCODE, const int A, const int M,
+					  const int C, uint8_t *result, uint8_t *flags) {
+	int value = 0;
+	int signedValue = 0;
+	bool carry = false;
+
+	switch( OPCODE ) {
+		case 0x7D: /* ADC */
+			value = A + M + C;
+			signedValue = (int8_t)A + (int8_t)M + C;
+			carry = value > 0xFF;
+			break;
+
+		case 0xFD: /* SBC */
+			value = A - M - (1 - C);
+			signedValue = (int8_t)A - (int8_t)M - (1 - C);
+			carry = value >= 0;
+			break;
+
+		case 0xDD: /* CMP */
+			value = A - M;
+			carry = A >= M;
+			break;
+
+		case 0x0A: /* ASL */
+			value = M << 1;
+			carry = M >= 0x80;
+			break;
+
+		case 0x4A: /* LSR */
+			value = M >> 1;
+			carry = (M & 1) != 0;
+			break;
+
+		case 0x2A: /* ROL */
+			value = M << 1 | C;
+			carry = M >= 0x80;
+			break;
+
+		case 0x6A: /* ROR */
+			value = M >> 1 | C << 7;
+			carry = (M & 1) != 0;
+			break;
+	}
+
+	const uint8_t BYTE = (uint8_t)value;
+	const bool OVERFLOW = signedValue < -128 || signedValue > 127;
+
+	*result = (OPCODE == 0xDD) ? (uint8_t)A : BYTE;
+	*flags = (uint8_t)((BYTE & SIGN_BIT) | (OVERFLOW ? OVERFLOW_BIT : 0) |
+					   (BYTE == 0 ? ZERO_BIT : 0) | (carry ? CARRY_BIT : 0));
+}
+
+static void _checkAluSweep(CPU *cpu, const WatchKind KIND,
+						   const uint16_t ADDRESS, const uint8_t VALUE,
+						   void *data) {
+	UNUSED(KIND);
+	AluSweep *sweep = data;
+
+	if( ADDRESS == 0x0200 ) {
+		sweep->result = VALUE;
+		return;
+	}
+
+	const uint8_t A = busReadRAM(&cpu->bus, 0x00);
+	const uint8_t C = busReadRAM(&cpu->bus, 0x01) & 1;
+	const uint8_t M = cpu->regX;
+
+	uint8_t result = 0;
+	uint8_t flags = 0;
+	_aluModel(sweep->opcode, A, M, C, &result, &flags);
+
+	/* Only ADC and SBC touch V */
+	const bool ARITH = sweep->opcode == 0x7D || sweep->opcode == 0xFD;
+	const uint8_t MASK = (uint8_t)(SIGN_BIT | ZERO_BIT | CARRY_BIT |
+								   (ARITH ? OVERFLOW_BIT : 0));
+
+	++sweep->checked;
+	if( sweep->result == result && (VALUE & MASK) == flags ) {
+		return;
+	}
+
+	if( sweep->failed++ == 0 ) {
+		printf("A=%02X M=%02X C=%u gave %02X P=%02X, expected %02X P=%02X\n",
+			   A, M, C, sweep->result, VALUE & MASK, result, flags);
+	}
+}
+
+static bool _aluSweep(const uint8_t OPCODE) {
+	uint8_t prog[0x28] = {
+		0xA9, 0x00, 0x85, 0x00, 0x85, 0x01, /* $00 = A, $01 = carry */
+		0xA2, 0x00,							/* Operand in X */
+		0xA5, 0x01, 0x4A,					/* Carry */
+		0x00, 0x00, 0x00, 0x00, 0x00,		/* Load and run OPCODE */
+		0x8D, 0x00, 0x02, 0x08, 0x68, 0x8D, 0x01, 0x02,
+		0xE8, 0xD0, 0xED,		/* Next operand */
+		0xE6, 0x00, 0xD0, 0xE7, /* Next A */
+		0xE6, 0x01, 0xA5, 0x01, 0xC9, 0x02, 0xD0, 0xDF,
+		0x00,
+	};
+
+	/* A comes from $00 and the operand from $0400,X, or for the shifts on A,
+	 * A is the operand
+	 */
+	const uint8_t LOAD[5] = {0xA5, 0x00, OPCODE, 0x00, 0x04};
+	const uint8_t SHIFT[5] = {0xBD, 0x00, 0x04, OPCODE, 0xEA};
+	memcpy(&prog[0x0B], ((OPCODE & 0x0F) == 0x0A) ? SHIFT : LOAD, 5);
+
+	TEST_MACHINE(prog, sizeof(prog));
+
+	for( uint16_t i = 0; i < 256; ++i ) {
+		cpuWrite(cpu, 0x0400 + i, (uint8_t)i);
+	}
+
+	AluSweep sweep = {.opcode = OPCODE};
+	watchAdd(cpu, WATCH_WRITE, 0x0200, 0x0201, _checkAluSweep, &sweep);
+
+	cpuRun(cpu);
+	watchClear(cpu);
+
+	RET(sweep.checked == ALU_SWEEP_PAIRS && sweep.failed == 0);
 }
 
 TEST_FN(_adc) {
 	TEST(4, 0xA9, 0x34, 0x69, 0x02);
-	RET((cpu.regA == 0x36) && (cpu.status.overflow == 0));
+	RET((cpu->regA == 0x36) && (cpu->status.overflow == 0));
 }
 
 TEST_FN(_adcOverflow) {
 	TEST(4, 0xA9, 0xFF, 0x69, 0x03);
-	RET((cpu.regA == 0x02) && (cpu.status.carry == 1));
+	RET((cpu->regA == 0x02) && (cpu->status.carry == 1));
+}
+
+TEST_FN(_adcAllPairs) {
+	return _aluSweep(0x7D);
 }
 
 TEST_FN(_and) {
 	TEST(4, 0xA9, 0xFF, 0x29, 0x01);
-	RET(cpu.regA == 0x01);
+	RET(cpu->regA == 0x01);
 }
 
 TEST_FN(_andZeroOut) {
 	TEST(4, 0xA9, 0x55, 0x29, 0xAA);
-	RET(cpu.regA == 0x00);
+	RET(cpu->regA == 0x00);
 }
 
 TEST_FN(_aslCFlag_set) {
 	TEST(3, 0xA9, 0x7F, 0x0A);
-	RET((cpu.regA == (0x7F << 1)) && (cpu.status.carry == 0));
+	RET((cpu->regA == (0x7F << 1)) && (cpu->status.carry == 0));
 }
 
 TEST_FN(_aslCFlag_nset) {
 	TEST(3, 0xA9, 0x80, 0x0A);
-	RET((cpu.regA == 0) && (cpu.status.carry == 1));
+	RET((cpu->regA == 0) && (cpu->status.carry == 1));
+}
+
+TEST_FN(_aslAllValues) {
+	return _aluSweep(0x0A);
+}
+
+TEST_FN(_lsrAllValues) {
+	return _aluSweep(0x4A);
+}
+
+TEST_FN(_rolAllValues) {
+	return _aluSweep(0x2A);
+}
+
+TEST_FN(_rorAllValues) {
+	return _aluSweep(0x6A);
+}
+
+TEST_FN(_cmpAllPairs) {
+	return _aluSweep(0xDD);
 }
 
 TEST_FN(_lda) {
 	TEST(2, 0xA9, 0x05);
 
-	RET((cpu.regA == 0x05) && (cpu.status.zero == 0) &&
-		(cpu.status.negative == 0));
+	RET((cpu->regA == 0x05) && (cpu->status.zero == 0) &&
+		(cpu->status.negative == 0));
 }
 
 TEST_FN(_ldaZFlag_set) {
 	TEST(2, 0xA9, 0x00);
-	RET(cpu.status.zero == 1);
+	RET(cpu->status.zero == 1);
 }
 
 TEST_FN(_ldaZFlag_nset) {
 	TEST(2, 0xA9, 0x12);
-	RET(cpu.status.zero == 0);
+	RET(cpu->status.zero == 0);
 }
 
 TEST_FN(_ldaNFlag_set) {
 	TEST(2, 0xA9, 0x80);
-	RET(cpu.status.negative == 1);
+	RET(cpu->status.negative == 1);
 }
 
 TEST_FN(_ldaNFlag_nset) {
 	TEST(2, 0xA9, 0x79);
-	RET(cpu.status.negative == 0);
+	RET(cpu->status.negative == 0);
 }
 
 TEST_FN(_ldaZP) {
-	CPU cpu;
 	const uint8_t PROG[3] = {0xA5, 0x10, 0x00};
 
-	_loadTestCode(&cpu, PROG, 3);
+	TEST_MACHINE(PROG, 3);
 
-	cpuWrite16(&cpu, 0x10, 0x55);
+	cpuWrite16(cpu, 0x10, 0x55);
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0x55);
+	RET(cpu->regA == 0x55);
 }
 
 TEST_FN(_ldaZP_x) {
-	CPU cpu;
 	const uint8_t PROG[3] = {0xB5, 0x10, 0x00};
 
-	_loadTestCode(&cpu, PROG, 3);
+	TEST_MACHINE(PROG, 3);
 
-	cpuWrite16(&cpu, 0x12, 0x35);
-	cpu.regX = 0x2;
+	cpuWrite16(cpu, 0x12, 0x35);
+	cpu->regX = 0x2;
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0x35);
+	RET(cpu->regA == 0x35);
 }
 
 TEST_FN(_ldaAbs) {
-	CPU cpu;
 	const uint8_t PROG[4] = {0xAD, 0xF2, 0x10, 0x00};
 
-	_loadTestCode(&cpu, PROG, 4);
+	TEST_MACHINE(PROG, 4);
 
-	cpuWrite(&cpu, 0x10F2, 0xFA);
+	cpuWrite(cpu, 0x10F2, 0xFA);
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0xFA);
+	RET(cpu->regA == 0xFA);
 }
 
 TEST_FN(_ldaAbs_x) {
-	CPU cpu;
 	const uint8_t PROG[4] = {0xBD, 0x08, 0x10, 0x00};
 
-	_loadTestCode(&cpu, PROG, 4);
+	TEST_MACHINE(PROG, 4);
 
-	cpuWrite(&cpu, 0x100A, 0xFA);
-	cpu.regX = 0x02;
+	cpuWrite(cpu, 0x100A, 0xFA);
+	cpu->regX = 0x02;
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0xFA);
+	RET(cpu->regA == 0xFA);
 }
 
 TEST_FN(_ldaAbs_y) {
-	CPU cpu;
 	const uint8_t PROG[4] = {0xB9, 0x12, 0x10, 0x00};
 
-	_loadTestCode(&cpu, PROG, 4);
+	TEST_MACHINE(PROG, 4);
 
-	cpuWrite(&cpu, 0x1014, 0xFA);
-	cpu.regY = 0x02;
+	cpuWrite(cpu, 0x1014, 0xFA);
+	cpu->regY = 0x02;
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0xFA);
+	RET(cpu->regA == 0xFA);
 }
 
 TEST_FN(_ldaInd_x) {
-	CPU cpu;
 	const uint8_t PROG[3] = {0xA1, 0x12, 0x00};
 
-	_loadTestCode(&cpu, PROG, 3);
+	TEST_MACHINE(PROG, 3);
 
-	cpuWrite16(&cpu, 0x0014, 0x0032);
-	cpuWrite16(&cpu, 0x0032, 0x9999);
-	cpu.regX = 0x02;
+	cpuWrite16(cpu, 0x0014, 0x0032);
+	cpuWrite16(cpu, 0x0032, 0x9999);
+	cpu->regX = 0x02;
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0x99);
+	RET(cpu->regA == 0x99);
 }
 
 TEST_FN(_ldaInd_y) {
-	CPU cpu;
 	const uint8_t PROG[3] = {0xB1, 0x20, 0x00};
 
-	_loadTestCode(&cpu, PROG, 3);
+	TEST_MACHINE(PROG, 3);
+
+	cpuWrite16(cpu, 0x0020, 0x0040);
+	cpuWrite16(cpu, 0x0044, 0x4545);
+	cpu->regY = 0x04;
+
+	cpuRun(cpu);
 
-	cpuWrite16(&cpu, 0x0020, 0x0040);
-	cpuWrite16(&cpu, 0x0044, 0x4545);
-	cpu.regY = 0x04;
+	RET(cpu->regA == 0x45);
+}
+
+TEST_FN(_ldaInd_yPointerWrap) {
+	const uint8_t PROG[3] = {0xB1, 0xFF, 0x00};
+
+	TEST_MACHINE(PROG, 3);
+
+	cpuWrite(cpu, 0x00FF, 0x40);
+	cpuWrite(cpu, 0x0000, 0x03);
+	cpuWrite(cpu, 0x0100, 0x07);
+	cpuWrite(cpu, 0x0341, 0x5A);
+	cpu->regY = 0x01;
 
-	cpuRun(&cpu);
+	cpuRun(cpu);
 
-	RET(cpu.regA == 0x45);
+	RET(cpu->regA == 0x5A);
 }
 
 TEST_FN(_sbc) {
 	TEST(5, 0xA9, 0xD3, 0x18, 0xE9, 0x01);
-	RET(cpu.regA == 0xD1);
+	RET(cpu->regA == 0xD1);
 }
 
 TEST_FN(_sbcZeroSubtractsOne) {
 	TEST(5, 0xA9, 0xD3, 0x18, 0xE9, 0x00);
-	RET(cpu.regA == 0xD2);
+	RET(cpu->regA == 0xD2);
 }
 
 TEST_FN(_sbcUnderflow) {
 	TEST(5, 0xA9, 0x00, 0x18, 0xE9, 0x02);
-	RET(cpu.regA == 0xFD);
+	RET(cpu->regA == 0xFD);
+}
+
+TEST_FN(_sbcAllPairs) {
+	return _aluSweep(0xFD);
 }
 
 TEST_FN(_staZP) {
 	TEST(4, 0xA9, 0x69, 0x85, 0x31);
-	RET(cpuRead(&cpu, 0x0031) == 0x69);
+	RET(cpuRead(cpu, 0x0031) == 0x69);
 }
 
 TEST_FN(_staZP_x) { /* TODO */
@@ -281,24 +471,238 @@ TEST_FN(_staInd_y) { /* TODO */
 
 TEST_FN(_tax) {
 	TEST(3, 0xA9, 0x52, 0xAA);
-	RET(cpu.regX == 0x52);
+	RET(cpu->regX == 0x52);
+}
+
+TEST_FN(_phpLazyFlags) {
+	TEST(3, 0xA9, 0x80, 0x08);
+	RET(cpuRead(cpu, 0x01FD) == 0xB4);
+}
+
+TEST_FN(_plpLazyFlags) {
+	TEST(4, 0xA9, 0x82, 0x48, 0x28);
+	RET((cpu->status.zero == 1) && (cpu->status.negative == 1));
+}
+
+static void _countWatch(CPU *cpu, const WatchKind KIND, const uint16_t ADDRESS,
+						const uint8_t VALUE, void *data) {
+	UNUSED(cpu);
+	UNUSED(KIND);
+	UNUSED(ADDRESS);
+	UNUSED(VALUE);
+
+	++*(uint8_t *)data;
+}
+
+TEST_FN(_watchWrite) {
+	const uint8_t PROG[9] = {0xA9, 0x01, 0x8D, 0x00, 0x02,
+							 0x8D, 0x00, 0x03, 0x00};
+
+	TEST_MACHINE(PROG, 8);
+
+	uint8_t hits = 0;
+	watchAdd(cpu, WATCH_WRITE, 0x0200, 0x02FF, _countWatch, &hits);
+
+	cpuRun(cpu);
+	watchClear(cpu);
+
+	RET(hits == 1);
+}
+
+typedef struct _OneShot {
+	int id;
+	uint8_t hits;
+} OneShot;
+
+static void _oneShotWatch(CPU *cpu, const WatchKind KIND,
+						  const uint16_t ADDRESS, const uint8_t VALUE,
+						  void *data) {
+	UNUSED(KIND);
+	UNUSED(ADDRESS);
+	UNUSED(VALUE);
+
+	OneShot *shot = data;
+	++shot->hits;
+	watchRemove(cpu, shot->id);
+}
+
+/* A watch that removes itself takes the list with it, mid notify */
+TEST_FN(_watchOneShot) {
+	const uint8_t PROG[9] = {0xA9, 0x01, 0x8D, 0x00, 0x02,
+							 0x8D, 0x00, 0x02, 0x00};
+
+	TEST_MACHINE(PROG, 8);
+
+	OneShot shot = {0, 0};
+	shot.id = watchAdd(cpu, WATCH_WRITE, 0x0200, 0x0200, _oneShotWatch, &shot);
+
+	cpuRun(cpu);
+
+	RET(shot.hits == 1 && cpu->watches == NULL);
+}
+
+TEST_FN(_watchExec) {
+	const uint8_t PROG[4] = {0xE8, 0xE8, 0xE8, 0x00};
+
+	TEST_MACHINE(PROG, 3);
+
+	uint8_t hits = 0;
+	const int ID =
+		watchAdd(cpu, WATCH_EXEC | WATCH_READ, 0x0601, 0x0602, _countWatch,
+				 &hits);
+	watchRemove(cpu, ID);
+	watchAdd(cpu, WATCH_EXEC, 0x0601, 0x0601, _countWatch, &hits);
+
+	cpuRun(cpu);
+	watchClear(cpu);
+
+	RET(hits == 1 && cpu->regX == 3);
+}
+
+TEST_FN(_idleLoopSkip) {
+	const uint8_t PROG[11] = {
+		0xA9, 0x80, 0x8D, 0x00, 0x20, /* Enable NMIs */
+		0xA5, 0x10, 0xF0, 0xFC,		  /* Wait for the handler to set $10 */
+		0xA6, 0x10,
+	};
+	const uint8_t HANDLER[3] = {0xE6, 0x10, 0x40};
+
+	TEST_MACHINE(PROG, 11);
+
+	for( uint8_t i = 0; i < 3; ++i ) {
+		cpuWrite(cpu, 0x0700 + i, HANDLER[i]);
+	}
+
+	cpu->bus.rom.prgRom[0x3FFA] = 0x00;
+	cpu->bus.rom.prgRom[0x3FFB] = 0x07;
+
+	cpuRun(cpu);
+
+	RET(cpu->regX == 1 && cpu->idleCycles > 0);
+}
+
+TEST_FN(_oamDMA) {
+	const uint8_t PROG[5] = {0xA9, 0x02, 0x8D, 0x14, 0x40};
+
+	TEST_MACHINE(PROG, 5);
+
+	for( uint16_t i = 0; i < 256; ++i ) {
+		cpuWrite(cpu, 0x0200 + i, (uint8_t)i);
+	}
+
+	cpu->bus.ppu.oamAddr = 0x04;
+	cpuRun(cpu);
+
+	/* LDA and STA, then the stall. The write starts on an even cycle */
+	RET(cpu->bus.ppu.oam[0x04] == 0x00 && cpu->bus.ppu.oam[0x03] == 0xFF &&
+		cpu->bus.ppu.oamAddr == 0x04 &&
+		cpu->bus.cycles == 2 + 4 + BUS_DMA_CYCLES);
+}
+
+/* Peeking at registers with read side effects leaves them alone */
+TEST_FN(_busPeek) {
+	const uint8_t PROG[1] = {0xEA};
+
+	TEST_MACHINE(PROG, 1);
+	PPU *ppu = &cpu->bus.ppu;
+
+	ppu->status.vblankStarted = 1;
+	ppuWriteAddr(ppu, 0x23);
+	ppuWriteAddr(ppu, 0x05);
+	ppu->internalBuffer = 0x55;
+	cpu->bus.joy1.data.bits = 0x01;
+
+	TEST_EQ((busPeek(&cpu->bus, 0x2002) & 0x80) != 0);
+	TEST_EQ(busPeek(&cpu->bus, 0x2007) == 0x55);
+	TEST_EQ(busPeek(&cpu->bus, 0x4016) == 0x41);
+	TEST_EQ(busPeek(&cpu->bus, 0x4016) == 0x41);
+
+	/* Past the end of RAM is its first mirror */
+	cpuWrite(cpu, 0x07FF, 0x12);
+	cpuWrite(cpu, 0x0000, 0x34);
+
+	uint8_t bytes[2];
+	busPeekRange(&cpu->bus, 0x07FF, bytes, sizeof(bytes));
+
+	RET(ppu->status.vblankStarted && addrGet(&ppu->addr) == 0x2305 &&
+		ppu->internalBuffer == 0x55 && cpu->bus.joy1.pointer == 0 &&
+		bytes[0] == 0x12 && bytes[1] == 0x34);
+}
+
+/* Indexed reads and taken branches pay extra for landing on another page */
+TEST_FN(_pageCrossCycles) {
+	const uint8_t PROG[12] = {
+		0xA2, 0x01,		  /* LDX #$01 */
+		0xBD, 0xFF, 0x02, /* LDA $02FF,X, crosses */
+		0xBD, 0x00, 0x02, /* LDA $0200,X */
+		0xF0, 0x00,		  /* BEQ, same page */
+		0xF0, 0x80,		  /* BEQ back to $058C, crosses */
+	};
+
+	TEST_MACHINE(PROG, 12);
+	cpuRun(cpu);
+
+	RET(cpu->bus.cycles == 2 + 5 + 4 + 3 + 4);
+}
+
+/* Turning NMIs on in the middle of vblank raises one right away */
+TEST_FN(_nmiLateEnable) {
+	const uint8_t PROG[7] = {
+		0xA9, 0x80, 0x8D, 0x00, 0x20, /* Enable NMIs */
+		0xA6, 0x10,
+	};
+	const uint8_t HANDLER[3] = {0xE6, 0x10, 0x40};
+
+	TEST_MACHINE(PROG, 7);
+
+	for( uint8_t i = 0; i < 3; ++i ) {
+		cpuWrite(cpu, 0x0700 + i, HANDLER[i]);
+	}
+
+	cpu->bus.rom.prgRom[0x3FFA] = 0x00;
+	cpu->bus.rom.prgRom[0x3FFB] = 0x07;
+
+	cpu->bus.ppu.status.vblankStarted = 1;
+	cpuRun(cpu);
+
+	RET(cpu->regX == 1 && cpu->pendingEvents == 0);
+}
+
+TEST_FN(_traceRing) {
+	const uint8_t PROG[4] = {0xA9, 0x12, 0xAA, 0x00};
+
+	TEST_MACHINE(PROG, 3);
+	cpuTraceEnable(cpu);
+	cpuRun(cpu);
+
+	char line[128];
+	cpuTraceFormat(traceGet(cpu->trace, 2), line, sizeof(line));
+
+	const bool RESULT =
+		cpu->trace->count == 3 && traceGet(cpu->trace, 0)->opcode == 0x00 &&
+		traceGet(cpu->trace, 1)->regA == 0x12 &&
+		strcmp(line, "0600  A9 12     LDA #$12                        "
+					 "A:00 X:00 Y:00 P:24 SP:FD CYC:0") == 0;
+
+	cpuTraceDisable(cpu);
+	RET(RESULT);
 }
 
 TEST_FN(_inx) {
 	TEST(4, 0xA9, 0x12, 0xAA, 0xE8);
-	RET(cpu.regX == 0x13);
+	RET(cpu->regX == 0x13);
 }
 
 TEST_FN(_inxOverflow) {
 	TEST(5, 0xA9, 0xFF, 0xAA, 0xE8, 0xE8);
-	RET(cpu.regX == 0x01);
+	RET(cpu->regX == 0x01);
 }
 
 /* LDA, TAX, INX and BRK working together
  */
 TEST_FN(_smallTest) {
 	TEST(4, 0xA9, 0xC0, 0xAA, 0xE8);
-	RET(cpu.regX == 0xC1);
+	RET(cpu->regX == 0xC1);
 }
 
 TEST_FN(_ppuVramW) {
@@ -428,6 +832,194 @@ TEST_FN(_ppuVram_mirroring) {
 	return (ppuRead(&ppu) == 0x66);
 }
 
+TEST_FN(_ppuPeekRange) {
+	PPU ppu;
+	ppuInitEmptyVertical(&ppu);
+
+	ppu.vram[0x03FF] = 0x66;
+	ppu.vram[0x0400] = 0x77;
+	ppu.palTable[0x00] = 0x0F;
+
+	/* $2BFF and $2C00 are the ends of the first and second nametable */
+	uint8_t bytes[2];
+	ppuPeekRange(&ppu, 0x2BFF, bytes, sizeof(bytes));
+
+	return bytes[0] == 0x66 && bytes[1] == 0x77 &&
+		   ppuPeek(&ppu, 0x3F10) == 0x0F && ppuPeek(&ppu, 0x3F30) == 0x0F;
+}
+
+/* Lines are drawn as they're crossed, so a scroll change mid-frame only
+ * shows up below it
+ */
+TEST_FN(_ppuScanlineSplit) {
+	static uint8_t chr[PPU_CHR_BANKS * PPU_CHR_BANK_SIZE];
+	memset(&chr[16], 0xFF, 8); /* Tile 1 is solid colour 1 */
+
+	static PPU ppu;
+	ppuInit(&ppu, chr, VERTICAL);
+
+	memset(ppu.vram, 1, 0x03C0);
+	ppu.palTable[0] = 0x0F;
+	ppu.palTable[1] = 0x30;
+	ppuWriteMask(&ppu, 0x08);
+
+	ppuTick(&ppu, 341 * 10);
+	ppuWriteControl(&ppu, 0x01); /* Scroll over to the blank nametable */
+	ppuTick(&ppu, 341 * 10);
+
+	return ppu.frame.pixels[5 * SCR_W] == 0x30 &&
+		   ppu.frame.pixels[15 * SCR_W] == 0x0F;
+}
+
+/* Decoded tiles follow CHR RAM writes and bank switches */
+TEST_FN(_ppuTileCache) {
+	static uint8_t chr[PPU_CHR_BANKS * PPU_CHR_BANK_SIZE];
+	static uint8_t other[PPU_CHR_BANK_SIZE];
+	memset(&chr[16], 0xFF, 8);	 /* Tile 1 is solid colour 1 */
+	memset(&other[24], 0xFF, 8); /* ... and solid colour 2 here */
+
+	static PPU ppu;
+	ppuInit(&ppu, chr, VERTICAL);
+	ppu.chrWritable = true;
+
+	TEST_EQ(ppuTile(&ppu, 1)[0] == 1);
+
+	/* Clear the first row of tile 1's low plane */
+	ppuWriteAddr(&ppu, 0x00);
+	ppuWriteAddr(&ppu, 0x10);
+	ppuWrite(&ppu, 0x00);
+
+	TEST_EQ(ppuTile(&ppu, 1)[0] == 0 && ppuTile(&ppu, 1)[8] == 1);
+
+	ppuMapChr(&ppu, 0, other);
+	return ppuTile(&ppu, 1)[0] == 2;
+}
+
+/* Every kernel this CPU runs decodes every pair of row bytes like the scalar
+ * one
+ */
+TEST_FN(_tileKernels) {
+	const TileDecodeFn SCALAR = tileKernel(TILE_SCALAR);
+
+	for( int kernel = TILE_SCALAR + 1; kernel < TILE_KERNELS; ++kernel ) {
+		const TileDecodeFn DECODE = tileKernel((TileKernel)kernel);
+		if( DECODE == NULL ) {
+			continue;
+		}
+
+		for( uint32_t pair = 0; pair < 0x10000; pair += 8 ) {
+			uint8_t planes[16];
+			for( uint8_t y = 0; y < 8; ++y ) {
+				planes[y] = (uint8_t)(pair + y);
+				planes[y + 8] = (uint8_t)((pair + y) >> 8);
+			}
+
+			uint8_t expected[64];
+			uint8_t got[64];
+			SCALAR(planes, expected);
+			DECODE(planes, got);
+
+			TEST_EQ(memcmp(expected, got, 64) == 0);
+		}
+	}
+
+	return true;
+}
+
+/* The background planes pick up nametable, attribute and CHR writes */
+TEST_FN(_ppuBGDirty) {
+	static uint8_t chr[PPU_CHR_BANKS * PPU_CHR_BANK_SIZE];
+	memset(&chr[16], 0xFF, 8); /* Tile 1 is solid colour 1 */
+
+	static PPU ppu;
+	ppuInit(&ppu, chr, VERTICAL);
+	ppu.chrWritable = true;
+
+	ppu.palTable[0] = 0x0F;
+	ppu.palTable[5] = 0x16;
+	ppuWriteMask(&ppu, 0x08);
+
+	ppuTick(&ppu, 341);
+	TEST_EQ(ppu.frame.pixels[0] == 0x0F && !ppu.bgDirtyAny);
+
+	/* Tile 1 in the top left corner, with palette 1 */
+	ppuWriteAddr(&ppu, 0x20);
+	ppuWriteAddr(&ppu, 0x00);
+	ppuWrite(&ppu, 0x01);
+
+	ppuWriteAddr(&ppu, 0x23);
+	ppuWriteAddr(&ppu, 0xC0);
+	ppuWrite(&ppu, 0x01);
+
+	ppuTick(&ppu, 341 * 262);
+	TEST_EQ(ppu.frame.pixels[0] == 0x16 && ppu.frame.pixels[8] == 0x0F);
+
+	/* Blank out the top row of tile 1 */
+	ppuWriteAddr(&ppu, 0x00);
+	ppuWriteAddr(&ppu, 0x10);
+	ppuWrite(&ppu, 0x00);
+
+	ppuTick(&ppu, 341 * 262);
+	return ppu.frame.pixels[0] == 0x0F && ppu.frame.pixels[SCR_W] == 0x16;
+}
+
+/* Lines keep their emphasis, and the LUT applies it when converting */
+TEST_FN(_frameConvert) {
+	static Frame frame;
+	frameInit(&frame);
+
+	frame.pixels[0] = 0x30;
+	frame.pixels[SCR_W] = 0x30;
+	frame.emphasis[1] = 1; /* Red */
+
+	static FrameLUT lut;
+	static uint32_t out[FRAME_SIZE];
+	frameLUTInitARGB(&lut);
+	frameConvert32(&frame, &lut, out);
+
+	return out[0] == 0xFFFFFFFF && out[SCR_W] == 0xFFFFBFBF &&
+		   out[1] == lut.colors[0][0];
+}
+
+/* Every SIMD line kernel matches the scalar one, for every byte a pixel
+ * could hold and every emphasis row
+ */
+TEST_FN(_frameKernels) {
+	uint8_t pixels[SCR_W];
+	for( size_t x = 0; x < SCR_W; ++x ) {
+		pixels[x] = (uint8_t)(x * 37);
+	}
+
+	static FrameLUT luts[2];
+	frameLUTInitARGB(&luts[0]);
+	frameLUTInitGray(&luts[1]);
+
+	for( int kernel = FRAME_SCALAR + 1; kernel < FRAME_KERNELS; ++kernel ) {
+		const FrameLine32Fn LINE32 = frameKernel32((FrameKernel)kernel);
+		const FrameLine8Fn LINE8 = frameKernel8((FrameKernel)kernel);
+
+		for( uint8_t i = 0; i < 2 * FRAME_EMPHASES; ++i ) {
+			const uint32_t *COLORS = luts[i & 1].colors[i >> 1];
+
+			uint32_t expected32[SCR_W], got32[SCR_W];
+			uint8_t expected8[SCR_W], got8[SCR_W];
+			frameKernel32(FRAME_SCALAR)(pixels, COLORS, expected32);
+			frameKernel8(FRAME_SCALAR)(pixels, COLORS, expected8);
+
+			if( LINE32 != NULL ) {
+				LINE32(pixels, COLORS, got32);
+				TEST_EQ(memcmp(expected32, got32, sizeof(got32)) == 0);
+			}
+			if( LINE8 != NULL ) {
+				LINE8(pixels, COLORS, got8);
+				TEST_EQ(memcmp(expected8, got8, sizeof(got8)) == 0);
+			}
+		}
+	}
+
+	return true;
+}
+
 TEST_FN(_ppuStatusR_resetLatch) {
 	TEST_PPU;
 	ppu.vram[0x0305] = 0x66;
@@ -548,18 +1140,258 @@ TEST_FN(_joyStrobe_onoff) {
 	return true;
 }
 
+/* Builds a cartridge for MAPPER where the first byte of each 8KB PRG bank and
+ * of each 1KB CHR bank holds its bank number. It resets to $0600 like the test
+ * ROM, and both NMI and IRQ go to $0700
+ */
+static Machine *_loadMapperROM(const uint8_t MAPPER, const uint8_t PRG_PAGES,
+							   const uint8_t CHR_PAGES) {
+	static uint8_t raw[16 + 8 * 0x4000 + 8 * 0x2000];
+	memset(raw, 0, sizeof(raw));
+
+	const uint8_t HEADER[8] = {'N', 'E', 'S', 0x1A, PRG_PAGES, CHR_PAGES,
+							   (uint8_t)(MAPPER << 4), MAPPER & 0xF0};
+	memcpy(raw, HEADER, 8);
+
+	for( uint8_t bank = 0; bank < PRG_PAGES * 2; ++bank ) {
+		raw[16 + bank * 0x2000] = bank;
+	}
+
+	const uint8_t VECTORS[6] = {0x00, 0x07, 0x00, 0x06, 0x00, 0x07};
+	memcpy(raw + 16 + PRG_PAGES * 0x4000 - 6, VECTORS, 6);
+
+	uint8_t *chr = raw + 16 + PRG_PAGES * 0x4000;
+	for( uint8_t bank = 0; bank < CHR_PAGES * 8; ++bank ) {
+		chr[bank * 0x0400] = bank;
+	}
+
+	ROM rom;
+	romInit(&rom, raw);
+
+	return machineCreate(&rom);
+}
+
+/* NROM has no registers, so ROM writes are ignored and the program goes on */
+TEST_FN(_mapperNROM) {
+	const uint8_t PROG[8] = {0xA9, 0x42, 0x8D, 0x00, 0x80, 0xE6, 0x10, 0x00};
+
+	Machine *machine = _loadMapperROM(0, 2, 1);
+	CPU *cpu = machineCPU(machine);
+
+	cpuLoad(cpu, PROG, 8);
+	cpuRun(cpu);
+
+	RET(cpuRead(cpu, 0x10) == 1 && cpuRead(cpu, 0x8000) == 0);
+}
+
+/* $8000 switches in 16KB, $C000 stays on the last bank */
+TEST_FN(_mapperUxROM) {
+	Machine *machine = _loadMapperROM(2, 4, 0);
+	CPU *cpu = machineCPU(machine);
+
+	TEST_EQ(cpuRead(cpu, 0xC000) == 6);
+
+	cpuWrite(cpu, 0x8000, 2);
+
+	RET(cpuRead(cpu, 0x8000) == 4 && cpuRead(cpu, 0xA000) == 5 &&
+		cpuRead(cpu, 0xC000) == 6 && cpu->bus.ppu.chrWritable);
+}
+
+/* Five serial writes to $E000 load the PRG register */
+TEST_FN(_mapperMMC1) {
+	Machine *machine = _loadMapperROM(1, 4, 2);
+	CPU *cpu = machineCPU(machine);
+
+	const uint8_t PRG = 2;
+	for( uint8_t i = 0; i < 5; ++i ) {
+		cpuWrite(cpu, 0xE000, (PRG >> i) & 1);
+	}
+
+	/* Control: vertical mirroring, last bank fixed, 4KB CHR banks */
+	const uint8_t CONTROL = 0x1E;
+	for( uint8_t i = 0; i < 5; ++i ) {
+		cpuWrite(cpu, 0x8000, (CONTROL >> i) & 1);
+	}
+
+	/* CHR 1: the second 4KB half of the second 8KB bank */
+	for( uint8_t i = 0; i < 5; ++i ) {
+		cpuWrite(cpu, 0xC000, (3 >> i) & 1);
+	}
+
+	RET(cpuRead(cpu, 0x8000) == 4 && cpuRead(cpu, 0xC000) == 6 &&
+		cpu->bus.ppu.mirroring == VERTICAL &&
+		*ppuChr(&cpu->bus.ppu, 0x1000) == 12);
+}
+
+/* R6 goes to $8000 or $C000 depending on the PRG mode */
+TEST_FN(_mapperMMC3) {
+	Machine *machine = _loadMapperROM(4, 4, 2);
+	CPU *cpu = machineCPU(machine);
+
+	cpuWrite(cpu, 0x8000, 6);
+	cpuWrite(cpu, 0x8001, 3);
+	TEST_EQ(cpuRead(cpu, 0x8000) == 3 && cpuRead(cpu, 0xC000) == 6);
+
+	cpuWrite(cpu, 0x8000, 0x40 | 2);
+	cpuWrite(cpu, 0x8001, 9);
+
+	RET(cpuRead(cpu, 0x8000) == 6 && cpuRead(cpu, 0xC000) == 3 &&
+		cpuRead(cpu, 0xE000) == 7 && *ppuChr(&cpu->bus.ppu, 0x1000) == 9);
+}
+
+/* With a latch of 9, the counter runs out on the tenth rendering scanline */
+TEST_FN(_mapperMMC3_irq) {
+	const uint8_t PROG[27] = {
+		0xA9, 0x08, 0x8D, 0x00, 0x20, /* Sprites at $1000 */
+		0xA9, 0x18, 0x8D, 0x01, 0x20, /* Rendering on */
+		0xA9, 0x09, 0x8D, 0x00, 0xC0, /* Latch */
+		0x8D, 0x01, 0xC0,			  /* Reload */
+		0x8D, 0x01, 0xE0,			  /* Enable */
+		0x58,						  /* CLI */
+		0xA5, 0x10, 0xF0, 0xFC,		  /* Wait for the handler */
+		0x00,
+	};
+	const uint8_t HANDLER[6] = {0x8D, 0x00, 0xE0, 0xE6, 0x10, 0x40};
+
+	Machine *machine = _loadMapperROM(4, 4, 2);
+	CPU *cpu = machineCPU(machine);
+
+	cpuLoad(cpu, PROG, 27);
+	for( uint8_t i = 0; i < 6; ++i ) {
+		cpuWrite(cpu, 0x0700 + i, HANDLER[i]);
+	}
+
+	cpuRun(cpu);
+	busSyncPPU(&cpu->bus);
+
+	RET(cpu->bus.ppu.scanline == 9 && cpu->bus.irqLines == 0);
+}
+
+/* A held IRQ only gets flagged to the CPU while I lets it through */
+TEST_FN(_irqMasked) {
+	const uint8_t PROG[2] = {0x58, 0x00}; /* CLI */
+	const uint8_t HANDLER[3] = {0xE6, 0x10, 0x00};
+
+	Machine *machine = _loadMapperROM(4, 4, 2);
+	CPU *cpu = machineCPU(machine);
+
+	busAssertIRQ(&cpu->bus, IRQ_MAPPER);
+	TEST_EQ(cpu->pendingEvents == 0);
+
+	cpuLoad(cpu, PROG, 2);
+	for( uint8_t i = 0; i < 3; ++i ) {
+		cpuWrite(cpu, 0x0700 + i, HANDLER[i]);
+	}
+
+	cpuRun(cpu);
+
+	RET(cpuRead(cpu, 0x10) == 1 && cpu->status.interrupt &&
+		cpu->bus.irqLines != 0 && cpu->pendingEvents == 0);
+}
+
+/* A PLP that clears I under a held IRQ takes it before the next instruction.
+ * The code runs from PRG ROM, so the JIT gets to compile it too
+ */
+TEST_FN(_plpUnmasksIRQ) {
+	const uint8_t PROG[3] = {0x4C, 0x01, 0x80};
+	const uint8_t CODE[7] = {
+		0xA9, 0x00, 0x48, 0x28, /* PLP with I clear */
+		0xE6, 0x10,				/* Skipped until the handler returns */
+		0x00,
+	};
+	const uint8_t HANDLER[5] = {0xA5, 0x10, 0x85, 0x11, 0x00};
+
+	Machine *machine = _loadMapperROM(0, 2, 1);
+	CPU *cpu = machineCPU(machine);
+
+	memcpy(cpu->bus.rom.prgRom + 1, CODE, 7);
+	cpuLoad(cpu, PROG, 3);
+	for( uint8_t i = 0; i < 5; ++i ) {
+		cpuWrite(cpu, 0x0700 + i, HANDLER[i]);
+	}
+
+	busAssertIRQ(&cpu->bus, IRQ_MAPPER);
+	cpuRun(cpu);
+
+	RET(cpuRead(cpu, 0x11) == 0 && cpuRead(cpu, 0x10) == 0);
+}
+
+/* A CHR switch with no PPU register access around it only changes the lines
+ * drawn after it. Each 8KB bank's first byte puts a pixel at x = 4 on the
+ * first row of tile 0 in bank 1, and nothing in bank 0
+ */
+TEST_FN(_mapperMidFrameChr) {
+	const uint8_t PROG[27] = {
+		0xA9, 0x08, 0x8D, 0x01, 0x20, /* Background on */
+		0xA0, 0x07, 0xCA, 0xD0, 0xFD, /* About 80 lines */
+		0x88, 0xD0, 0xFA,
+		0xA9, 0x01, 0x8D, 0x00, 0x80, /* CHR bank 1 */
+		0xA0, 0x07, 0xCA, 0xD0, 0xFD, /* About 80 more */
+		0x88, 0xD0, 0xFA,
+		0x00,
+	};
+
+	Machine *machine = _loadMapperROM(3, 2, 2);
+	CPU *cpu = machineCPU(machine);
+
+	cpu->bus.ppu.palTable[0] = 0x0F;
+	cpu->bus.ppu.palTable[1] = 0x30;
+
+	cpuLoad(cpu, PROG, 27);
+	cpuRun(cpu);
+	busSyncPPU(&cpu->bus);
+
+	const uint8_t *PIXELS = cpu->bus.ppu.frame.pixels;
+	RET(cpu->bus.ppu.scanline > 152 && PIXELS[4] == 0x0F &&
+		PIXELS[152 * SCR_W + 4] == 0x30);
+}
+
+TEST_FN(_prgRam) {
+	TEST(10, 0xA9, 0x42, 0x8D, 0x00, 0x60, 0xAD, 0x00, 0x60, 0xAA, 0xE8);
+	RET(cpu->regX == 0x43 && cpu->bus.rom.prgRam[0] == 0x42);
+}
+
+/* Battery RAM written through the mapping is there when it's mapped again */
+TEST_FN(_saveMap) {
+	const char *PATH = "nesinc_test.sav";
+	remove(PATH);
+
+	uint8_t *data = saveMap(PATH, 0x2000);
+	TEST_NEQ(data == NULL);
+
+	data[0x0000] = 0x12;
+	data[0x1FFF] = 0x34;
+	saveUnmap(data, 0x2000);
+
+	data = saveMap(PATH, 0x2000);
+	TEST_NEQ(data == NULL);
+
+	const bool KEPT = data[0x0000] == 0x12 && data[0x1FFF] == 0x34;
+	saveUnmap(data, 0x2000);
+	remove(PATH);
+
+	return KEPT;
+}
+
 bool testRun(void) {
 	printf("\nStarting test run...\n");
 
 	printf("1. CPU Tests:\n");
 	RUN_TEST(_adc);
 	RUN_TEST(_adcOverflow);
+	RUN_TEST(_adcAllPairs);
 
 	RUN_TEST(_and);
 	RUN_TEST(_andZeroOut);
 
 	RUN_TEST(_aslCFlag_set);
 	RUN_TEST(_aslCFlag_nset);
+	RUN_TEST(_aslAllValues);
+	RUN_TEST(_lsrAllValues);
+	RUN_TEST(_rolAllValues);
+	RUN_TEST(_rorAllValues);
+
+	RUN_TEST(_cmpAllPairs);
 
 	RUN_TEST(_inx);
 	RUN_TEST(_inxOverflow);
@@ -581,10 +1413,12 @@ bool testRun(void) {
 
 	RUN_TEST(_ldaInd_x);
 	RUN_TEST(_ldaInd_y);
+	RUN_TEST(_ldaInd_yPointerWrap);
 
 	RUN_TEST(_sbc);
 	RUN_TEST(_sbcZeroSubtractsOne);
 	RUN_TEST(_sbcUnderflow);
+	RUN_TEST(_sbcAllPairs);
 
 	RUN_TEST(_staZP);
 	RUN_TEST(_staZP_x);
@@ -598,9 +1432,38 @@ bool testRun(void) {
 
 	RUN_TEST(_tax);
 
+	RUN_TEST(_phpLazyFlags);
+	RUN_TEST(_plpLazyFlags);
+
+	RUN_TEST(_watchWrite);
+	RUN_TEST(_watchExec);
+	RUN_TEST(_watchOneShot);
+
+	RUN_TEST(_pageCrossCycles);
+	RUN_TEST(_idleLoopSkip);
+	RUN_TEST(_nmiLateEnable);
+
+	RUN_TEST(_traceRing);
+	RUN_TEST(_oamDMA);
+	RUN_TEST(_busPeek);
+
 	RUN_TEST(_smallTest);
 
-	printf("2. PPU Tests:\n");
+	printf("2. Mapper Tests:\n");
+
+	RUN_TEST(_mapperNROM);
+	RUN_TEST(_mapperUxROM);
+	RUN_TEST(_mapperMMC1);
+	RUN_TEST(_mapperMMC3);
+	RUN_TEST(_mapperMMC3_irq);
+	RUN_TEST(_irqMasked);
+	RUN_TEST(_plpUnmasksIRQ);
+	RUN_TEST(_mapperMidFrameChr);
+
+	RUN_TEST(_prgRam);
+	RUN_TEST(_saveMap);
+
+	printf("3. PPU Tests:\n");
 
 	RUN_TEST(_ppuVramW);
 
@@ -611,6 +1474,13 @@ bool testRun(void) {
 	RUN_TEST(_ppuVram_horizontalMirror);
 	RUN_TEST(_ppuVram_verticalMirror);
 	RUN_TEST(_ppuVram_mirroring);
+	RUN_TEST(_ppuPeekRange);
+	RUN_TEST(_ppuScanlineSplit);
+	RUN_TEST(_ppuTileCache);
+	RUN_TEST(_tileKernels);
+	RUN_TEST(_ppuBGDirty);
+	RUN_TEST(_frameConvert);
+	RUN_TEST(_frameKernels);
 
 	RUN_TEST(_ppuStatusR_resetLatch);
 	RUN_TEST(_ppuStatusR_resetVBlank);
@@ -0,0 +1,27 @@
+#include "trace.h"
+
+#include <stdlib.h>
+
+#include "error.h"
+
+Trace *traceCreate(void) {
+	Trace *trace = calloc(1, sizeof(Trace));
+	if( trace == NULL ) {
+		errPrint(C_RED, "Not enough memory for the trace");
+		exit(71);
+	}
+
+	return trace;
+}
+
+void traceDestroy(Trace *trace) {
+	free(trace);
+}
+
+const TraceRecord *traceGet(const Trace *TRACE, const size_t AGO) {
+	if( AGO >= TRACE->count || AGO >= TRACE_SIZE ) {
+		return NULL;
+	}
+
+	return &TRACE->records[(TRACE->count - 1 - AGO) & (TRACE_SIZE - 1)];
+}
@@ -0,0 +1,102 @@
+#include "watch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "error.h"
+
+static void _rebuildPages(WatchList *list) {
+	memset(list->pages, 0, sizeof(list->pages));
+
+	for( uint8_t i = 0; i < WATCH_MAX; ++i ) {
+		const Watch *WATCH = &list->watches[i];
+		if( WATCH->kinds == 0 ) {
+			continue;
+		}
+
+		for( uint16_t page = WATCH->start >> 8; page <= (WATCH->end >> 8);
+			 ++page ) {
+			list->pages[page] |= WATCH->kinds;
+		}
+	}
+}
+
+int watchAdd(CPU *cpu, const uint8_t KINDS, const uint16_t START,
+			 const uint16_t END, WatchFn fn, void *data) {
+	if( cpu->watches == NULL ) {
+		cpu->watches = calloc(1, sizeof(WatchList));
+		if( cpu->watches == NULL ) {
+			errPrint(C_RED, "Not enough memory for watches");
+			exit(71);
+		}
+	}
+
+	for( uint8_t i = 0; i < WATCH_MAX; ++i ) {
+		Watch *watch = &cpu->watches->watches[i];
+		if( watch->kinds != 0 ) {
+			continue;
+		}
+
+		*watch = (Watch){fn, data, START, END, KINDS};
+		_rebuildPages(cpu->watches);
+
+		return i;
+	}
+
+	return -1;
+}
+
+void watchRemove(CPU *cpu, const int ID) {
+	if( cpu->watches == NULL || ID < 0 || ID >= WATCH_MAX ) {
+		return;
+	}
+
+	cpu->watches->watches[ID].kinds = 0;
+	_rebuildPages(cpu->watches);
+
+	/* Dropping the list once it's empty gets the CPU back to the NULL check */
+	for( uint8_t i = 0; i < WATCH_MAX; ++i ) {
+		if( cpu->watches->watches[i].kinds != 0 ) {
+			return;
+		}
+	}
+
+	watchClear(cpu);
+}
+
+void watchClear(CPU *cpu) {
+	WatchList *list = cpu->watches;
+	cpu->watches = NULL;
+
+	if( list == NULL ) {
+		return;
+	}
+
+	/* Cleared from a callback: the watchNotify running it frees the list */
+	if( list->notifying > 0 ) {
+		memset(list->watches, 0, sizeof(list->watches));
+		list->freePending = true;
+		return;
+	}
+
+	free(list);
+}
+
+void watchNotify(CPU *cpu, const WatchKind KIND, const uint16_t ADDRESS,
+				 const uint8_t VALUE) {
+	WatchList *list = cpu->watches;
+	++list->notifying;
+
+	for( uint8_t i = 0; i < WATCH_MAX; ++i ) {
+		const Watch *WATCH = &list->watches[i];
+
+		if( (WATCH->kinds & KIND) != 0 && ADDRESS >= WATCH->start &&
+			ADDRESS <= WATCH->end ) {
+			WATCH->fn(cpu, KIND, ADDRESS, VALUE, WATCH->data);
+		}
+	}
+
+	if( --list->notifying == 0 && list->freePending ) {
+		free(list);
+	}
+}